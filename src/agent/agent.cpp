@@ -48,6 +48,11 @@ void Agent::setNode(Node* _v) {
   v = _v;
 }
 
+void Agent::relocate(Node* _v) {
+  beforeNode = v;
+  v = _v;
+}
+
 void Agent::updateHist() {
   AgentStatus* s = new AgentStatus;
   s->v = v;
@@ -43,6 +43,7 @@ public:
 
   Node* getNode() { return v; }
   void setNode(Node* _v);
+  void relocate(Node* _v);  // without checking adjacency, e.g., observations
   Node* getBeforeNode() { return beforeNode; }
   void setBeforeNode(Node* _v) { beforeNode = _v; }
 
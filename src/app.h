@@ -22,6 +22,7 @@
 
 #include "solver/pibt.h"
 #include "solver/winpibt.h"
+#include "solver/ppibt.h"
 #include "solver/cbs.h"
 #include "solver/ecbs.h"
 #include "solver/iecbs.h"
@@ -84,6 +85,11 @@ Problem* run(int argc, char *argv[])
      5,      // WHCA* or winPIBT, window size
      1.5,    // ECBS or iECBS, suboptimal param
      true,   // winPIBT, softmode
+     0,      // PIBT, deadline of one step [ms]
+     false,  // PIBT, density-based priority
+     1,      // CBS, ECBS or pPIBT, threads
+     false,  // CBS, cardinal conflicts first
+     false,  // CBS or ECBS, bypass
     };
   Param::VisualConfig* visualConfig = new Param::VisualConfig
     {
@@ -185,7 +191,13 @@ Problem* run(int argc, char *argv[])
       std::cout << "error@run, CBS cannot solve except MAPF" << "\n";
       std::exit(1);
     }
-    solver = new CBS(P, solverConfig->ID);
+    {
+      CBS* cbs = new CBS(P, solverConfig->ID);
+      cbs->setThreads(solverConfig->threads);
+      cbs->setCardinal(solverConfig->cardinal);
+      cbs->setBypass(solverConfig->bypass);
+      solver = cbs;
+    }
     break;
   case Param::SOLVER_TYPE::S_ECBS:
     if (envConfig->PTYPE != Param::PROBLEM_TYPE::P_MAPF &&
@@ -193,7 +205,12 @@ Problem* run(int argc, char *argv[])
       std::cout << "error@run, ECBS cannot solve except MAPF" << "\n";
       std::exit(1);
     }
-    solver = new ECBS(P, solverConfig->suboptimal, solverConfig->ID);
+    {
+      ECBS* ecbs = new ECBS(P, solverConfig->suboptimal, solverConfig->ID);
+      ecbs->setThreads(solverConfig->threads);
+      ecbs->setBypass(solverConfig->bypass);
+      solver = ecbs;
+    }
     break;
   case Param::SOLVER_TYPE::S_iECBS:
     if (envConfig->PTYPE != Param::PROBLEM_TYPE::P_MAPF &&
@@ -228,7 +245,24 @@ Problem* run(int argc, char *argv[])
     solver = new PPS(P);
     break;
   case Param::SOLVER_TYPE::S_PIBT:
-    solver = new PIBT(P, MT_S);
+    {
+      PIBT* pibt = new PIBT(P, MT_S);
+      pibt->setDeadline(solverConfig->deadline);
+      pibt->setDensityMode(solverConfig->density);
+      solver = pibt;
+    }
+    break;
+  case Param::SOLVER_TYPE::S_pPIBT:
+    if (solverConfig->deadline > 0) {
+      std::cout << "error@run, pPIBT does not support deadline" << "\n";
+      std::exit(1);
+    }
+    {
+      pPIBT* ppibt = new pPIBT(P, MT_S);
+      ppibt->setThreads(solverConfig->threads);
+      ppibt->setDensityMode(solverConfig->density);
+      solver = ppibt;
+    }
     break;
   case Param::SOLVER_TYPE::S_winPIBT:
     solver = new winPIBT(P, solverConfig->window,
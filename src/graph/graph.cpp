@@ -25,6 +25,7 @@ Graph::Graph(std::mt19937* _MT) : MT(_MT) {
 void Graph::init() {
   directed = false;
   regFlg = true;
+  lockFlg = false;
 }
 
 Graph::~Graph() {
@@ -74,29 +75,41 @@ Nodes Graph::neighbor(int i) {
   return getNode(i)->getNeighbor();
 }
 
-Nodes Graph::getPath(Node* s, Node* g, Nodes &prohibitedNodes) {
+Nodes Graph::getPath(Node* s, Node* g, const Nodes &prohibitedNodes) {
   return {};
 }
 
 // regFlg : whether register
 Nodes Graph::getPath(Node* _s, Node* _g,
-                     Nodes &prohibitedNodes, int (*dist) (Node*, Node*))
+                     const Nodes &prohibitedNodes, int (*dist) (Node*, Node*))
 {
   bool prohibited = !prohibitedNodes.empty();
   Nodes path, C;
-  std::string key;
+  KnownPath* known;
 
   // ==== fast implementation ====
   if (regFlg && !prohibited) {
-    key = getKey(_s, _g);
-    auto itrK = knownPaths.find(key);
-    if (itrK != knownPaths.end()) {  // known
-      path = itrK->second->path;
+    known = findKnownPath(_s, _g);
+    if (known != nullptr) {  // known
+      path = known->path;
       return path;
     }
   }
   // =============================
 
+  // mark prohibited nodes, unmarked after the search
+  // with threads, each search marks its own flags
+  std::vector<bool> localFlg;
+  std::vector<bool>& marked = lockFlg ? localFlg : prohibitedFlg;
+  if (prohibited) {
+    if (marked.size() != nodes.size()) {
+      marked = std::vector<bool>(nodes.size(), false);
+    }
+    for (auto v : prohibitedNodes) {
+      if (v != nullptr) marked[v->getIndex()] = true;
+    }
+  }
+
   int f;
   bool invalid = true;
 
@@ -119,14 +132,13 @@ Nodes Graph::getPath(Node* _s, Node* _g,
     }
 
     // ==== fast implementation ====
-    key = getKey(n->v, _g);
-    auto itrK = knownPaths.find(key);
-    if (itrK != knownPaths.end()) {  // known
-      Nodes kPath = itrK->second->path;
+    known = findKnownPath(n->v, _g);
+    if (known != nullptr) {  // known
+      const Nodes& kPath = known->path;
       bool valid = true;
       if (prohibited) {
         for (auto v : kPath) {
-          if (inArray(v, prohibitedNodes)) {
+          if (marked[v->getIndex()]) {
             valid = false;
             break;
           }
@@ -150,16 +162,15 @@ Nodes Graph::getPath(Node* _s, Node* _g,
     C = neighbor(n->v);
 
     for (auto m : C) {
-      if (prohibited && inArray(m, prohibitedNodes)) continue;
+      if (prohibited && marked[m->getIndex()]) continue;
       if (CLOSE.find(m->getId()) != CLOSE.end()) continue;
       f = n->g + 1 + dist(m, _g);
 
       // ==== fast implementation ====
       if (regFlg) {
-        key = getKey(m, _g);
-        auto itrK = knownPaths.find(key);
-        if (itrK != knownPaths.end()) {
-          f = n->g + 1 + itrK->second->path.size() - 1;
+        known = findKnownPath(m, _g);
+        if (known != nullptr) {
+          f = n->g + 1 + known->path.size() - 1;
         }
       }
       // =============================
@@ -182,6 +193,12 @@ Nodes Graph::getPath(Node* _s, Node* _g,
     }
   }
 
+  if (prohibited) {
+    for (auto v : prohibitedNodes) {
+      if (v != nullptr) marked[v->getIndex()] = false;
+    }
+  }
+
   if (invalid) return path;
 
   // back tracking
@@ -192,11 +209,24 @@ Nodes Graph::getPath(Node* _s, Node* _g,
   std::reverse(path.begin(), path.end());
 
   // register path
-  if (regFlg && !prohibited) registerPath(path);
+  if (regFlg && !prohibited) {
+    std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
+    if (lockFlg) lock.lock();
+    registerPath(path);
+  }
 
   return path;
 }
 
+// registered paths are never changed, safe to read without the lock
+KnownPath* Graph::findKnownPath(Node* s, Node* g) {
+  std::string key = getKey(s, g);
+  std::unique_lock<std::mutex> lock(mtx, std::defer_lock);
+  if (lockFlg) lock.lock();
+  auto itr = knownPaths.find(key);
+  return (itr == knownPaths.end()) ? nullptr : itr->second;
+}
+
 std::string Graph::getKey(Node* s, Node* g) {
   int sIndex = getNodeIndex(s);
   int gIndex = getNodeIndex(g);
@@ -218,8 +248,9 @@ void Graph::registerPath(const Nodes &path) {
     v1 = tmp[0];
     v2 = tmp[tmp.size() - 1];
     key = getKey(v1, v2);
-    KnownPath* knownPath = new KnownPath { v1, v2, tmp };
-    knownPaths.emplace(key, knownPath);
+    if (knownPaths.find(key) == knownPaths.end()) {  // registered by another search
+      knownPaths.emplace(key, new KnownPath { v1, v2, tmp });
+    }
     tmp.erase(tmp.begin());
   } while (tmp.size() > 2);
 }
@@ -4,6 +4,7 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <mutex>
 #include <unordered_map>
 #include "node.h"
 
@@ -44,6 +45,10 @@ private:
   // register path or not
   bool regFlg;
 
+  // lock knownPaths or not, for solvers with threads
+  bool lockFlg;
+  std::mutex mtx;
+
 protected:
   // nodes
   Nodes nodes;
@@ -51,6 +56,9 @@ protected:
   // cache of searched path
   std::unordered_map<std::string, KnownPath*> knownPaths;
 
+  // node index -> prohibited or not, used in getPath
+  std::vector<bool> prohibitedFlg;
+
   // random generator
   std::mt19937* MT;
 
@@ -60,10 +68,11 @@ protected:
 
   void init();
   Nodes getPath(Node* s, Node* g, int (*dist)(Node*, Node*));
-  Nodes getPath(Node* s, Node* g, Nodes &prohibitedNodes,
+  Nodes getPath(Node* s, Node* g, const Nodes &prohibitedNodes,
                 int (*dist)(Node*, Node*));
   std::string getKey(Node* s, Node* g);
   void registerPath(const Nodes &path);
+  KnownPath* findKnownPath(Node* s, Node* g);  // nullptr -> unknown
 
 public:
   Graph();
@@ -92,10 +101,13 @@ public:
   // register path or not
   void setRegFlg(bool flg) { regFlg = flg; }
 
+  // called by several threads or not
+  void setLockFlg(bool flg) { lockFlg = flg; }
+
   // typical exampl: manhattan distance
   virtual int dist(Node* v1, Node* v2) { return 0; }
   virtual Nodes getPath(Node* s, Node* g) { return {}; }
-  virtual Nodes getPath(Node* s, Node* g, Nodes &prohibitedNodes);
+  virtual Nodes getPath(Node* s, Node* g, const Nodes &prohibitedNodes);
 
   virtual Paths getRandomStartGoal(int num);
   // for iterative MAPF
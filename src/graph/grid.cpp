@@ -29,7 +29,7 @@ Nodes Grid::getPath(Node* s, Node* g) {
   return Graph::getPath(s, g, nodes, manhattanDist);
 }
 
-Nodes Grid::getPath(Node* s, Node* g, Nodes &prohibitedNodes) {
+Nodes Grid::getPath(Node* s, Node* g, const Nodes &prohibitedNodes) {
   return Graph::getPath(s, g, prohibitedNodes, manhattanDist);
 }
 
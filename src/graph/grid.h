@@ -22,7 +22,7 @@ public:
   static int manhattanDist(Node* v, Node* u);
 
   Nodes getPath(Node* s, Node* g);
-  Nodes getPath(Node* s, Node* g, Nodes &prohibitedNodes);
+  Nodes getPath(Node* s, Node* g, const Nodes &prohibitedNodes);
   Nodes getPath(int s, int g);
 
   int dist(Node* v1, Node* v2) { return manhattanDist(v1, v2); }
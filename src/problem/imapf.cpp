@@ -39,6 +39,7 @@ bool IMAPF::isSolved() {
   if (taskSum < taskLimit) return false;
   // check all tasks are completed or not
   for (int i = 0; i < taskLimit; ++i) {
+    if (T_DROP.find(i) != T_DROP.end()) continue;  // of a removed agent
     auto itr = std::find_if(T_CLOSE.begin(), T_CLOSE.end(),
                             [i] (Task* tau) { return tau->getId() == i; });
     if (itr == T_CLOSE.end()) return false;
@@ -58,7 +59,7 @@ void IMAPF::update() {
         ++taskSum;
         tau->setEndTime(timestep);
         a->releaseTask();
-        openToClose(tau, T_OPEN, T_CLOSE);
+        closeTask(tau);
         allocate(a);
         a->goalUpdated(true);
       } else {
@@ -78,7 +79,12 @@ void IMAPF::allocate(Agent* a) {
   Task* tau = new Task(v, timestep);
   a->setTask(tau);
   a->setGoal(a->getTask()->getG()[0]);
-  T_OPEN.push_back(tau);
+  openTask(tau);
+}
+
+void IMAPF::addAgent(Agent* a) {
+  allocate(a);
+  Problem::addAgent(a);
 }
 
 std::string IMAPF::logStr() {
@@ -12,6 +12,7 @@ private:
 
   void init();
   void allocate(Agent* a);
+  void dropTask(Task* tau) { discardTask(tau); }  // goals are personal
 
 public:
   IMAPF(Graph* _G, Agents _A, int _taskLimit);
@@ -20,6 +21,7 @@ public:
 
   bool isSolved();
   void update();
+  void addAgent(Agent* a);
 
   std::string logStr();
 };
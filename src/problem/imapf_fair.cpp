@@ -48,7 +48,7 @@ void IMAPF_FAIR::update() {
         goalCounts[i] += 1;
         tau->setEndTime(timestep);
         a->releaseTask();
-        openToClose(tau, T_OPEN, T_CLOSE);
+        closeTask(tau);
         allocate(a);
         a->goalUpdated(true);
       } else {
@@ -75,7 +75,21 @@ void IMAPF_FAIR::allocate(Agent* a) {
   Task* tau = new Task(v, timestep);
   a->setTask(tau);
   a->setGoal(a->getTask()->getG()[0]);
-  T_OPEN.push_back(tau);
+  openTask(tau);
+}
+
+void IMAPF_FAIR::addAgent(Agent* a) {
+  goalCounts.push_back(0);
+  allocate(a);
+  Problem::addAgent(a);
+}
+
+void IMAPF_FAIR::removeAgent(Agent* a) {
+  // keep goalCounts aligned with A
+  int i = agentIndex.at(a->getId());
+  goalCounts[i] = goalCounts[goalCounts.size() - 1];
+  goalCounts.pop_back();
+  Problem::removeAgent(a);
 }
 
 std::string IMAPF_FAIR::logStr() {
@@ -9,6 +9,7 @@ private:
   std::vector<int> goalCounts;
   void init();
   void allocate(Agent* a);
+  void dropTask(Task* tau) { discardTask(tau); }  // goals are personal
 
 public:
   IMAPF_FAIR(Graph* _G, Agents _A, int _taskLimit);
@@ -17,6 +18,8 @@ public:
 
   bool isSolved();
   void update();
+  void addAgent(Agent* a);
+  void removeAgent(Agent* a);
 
   std::string logStr();
 };
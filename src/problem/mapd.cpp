@@ -79,7 +79,7 @@ void MAPD::autoAssign() {
           tau->update(a->getNode());
         }
         a->setGoal(tau->getG()[0]);
-        openToClose(tau, T_OPEN, T_CLOSE);
+        closeTask(tau);
         break;
       }
     }
@@ -97,6 +97,7 @@ void MAPD::updateStatus() {
     }
     if (a->getTask()->completed()) {
       a->getTask()->setEndTime(timestep);
+      closeIndex.erase(a->getTask()->getId());  // never reopened
       a->releaseTask();
     }
   }
@@ -126,7 +127,7 @@ void MAPD::createTask() {
       Task* tau = new Task(timestep);
       tau->addNode(p);  // pickup
       tau->addNode(d);  // delivery
-      T_OPEN.push_back(tau);
+      openTask(tau);
       ++taskCnt;
     }
   }
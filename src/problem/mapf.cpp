@@ -54,14 +54,14 @@ void MAPF::update() {
       tau->update(a->getNode());  // update task status
       if (tau->completed()) {  // if task is completed
         a->releaseTaskOnly();  // agent release task, not goal
-        openToClose(tau, T_OPEN, T_CLOSE);
+        closeTask(tau);
       }
     } else if (a->getNode() != a->getGoal()) {
       // create new task and assign
       Task* newTau = new Task(a->getGoal());
       a->setTask(newTau);
       a->setGoal(newTau->getG()[0]);
-      T_OPEN.push_back(newTau);
+      openTask(newTau);
     }
     a->updateHist();
   }
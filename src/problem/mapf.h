@@ -5,6 +5,7 @@
 class MAPF : public Problem {
 private:
   void init();
+  void dropTask(Task* tau) { discardTask(tau); }  // nobody else reaches the goal
 
 public:
   MAPF(Graph* _G,
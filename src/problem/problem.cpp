@@ -7,6 +7,7 @@
 
 #include "problem.h"
 #include "../util/util.h"
+#include <algorithm>
 #include <random>
 
 
@@ -39,18 +40,106 @@ Problem::Problem(Graph* _G,
 
 void Problem::init() {
   timestep = 0;
+  for (int i = 0; i < A.size(); ++i) agentIndex.emplace(A[i]->getId(), i);
+  for (int i = 0; i < T_OPEN.size(); ++i) openIndex.emplace(T_OPEN[i]->getId(), i);
+  openStamp = 0;
 }
 
 Problem::~Problem() {
   for (auto a : A) delete a;
   for (auto t : T_OPEN) delete t;
   for (auto t : T_CLOSE) delete t;
+  for (auto itr : T_DROP) delete itr.second;
   A.clear();
   T_OPEN.clear();
 }
 
 void Problem::assign(Task* tau) {
-  openToClose(tau, T_OPEN, T_CLOSE);
+  closeTask(tau);
+}
+
+void Problem::openTask(Task* tau) {
+  openIndex[tau->getId()] = T_OPEN.size();
+  T_OPEN.push_back(tau);
+  ++openStamp;
+}
+
+bool Problem::removeOpen(Task* tau) {
+  auto itr = openIndex.find(tau->getId());
+  if (itr == openIndex.end()) return false;
+  int i = itr->second;
+  openIndex.erase(itr);
+  if (i != T_OPEN.size() - 1) {
+    T_OPEN[i] = T_OPEN[T_OPEN.size() - 1];
+    openIndex.at(T_OPEN[i]->getId()) = i;
+  }
+  T_OPEN.pop_back();
+  ++openStamp;
+  return true;
+}
+
+// completed tasks never reopen, hence not indexed
+void Problem::closeTask(Task* tau) {
+  if (!removeOpen(tau)) return;
+  if (!tau->completed()) closeIndex[tau->getId()] = T_CLOSE.size();
+  T_CLOSE.push_back(tau);
+}
+
+// the last task of T_CLOSE takes the place
+void Problem::reopenTask(Task* tau) {
+  auto itr = closeIndex.find(tau->getId());
+  if (itr == closeIndex.end()) return;
+  int i = itr->second;
+  closeIndex.erase(itr);
+  if (i != T_CLOSE.size() - 1) {
+    T_CLOSE[i] = T_CLOSE[T_CLOSE.size() - 1];
+    auto last = closeIndex.find(T_CLOSE[i]->getId());
+    if (last != closeIndex.end()) last->second = i;
+  }
+  T_CLOSE.pop_back();
+  openTask(tau);
+}
+
+void Problem::discardTask(Task* tau) {
+  if (!removeOpen(tau)) return;
+  T_DROP.emplace(tau->getId(), tau);
+}
+
+// assigned tasks are in T_CLOSE, e.g., MAPD
+void Problem::dropTask(Task* tau) {
+  tau->reset();
+  reopenTask(tau);
+}
+
+void Problem::addAgent(Agent* a) {
+  if (agentIndex.find(a->getId()) != agentIndex.end()) {
+    std::cout << "error@Problem::addAgent, agent "
+              << a->getId() << " already exists" << "\n";
+    std::exit(1);
+  }
+  agentIndex.emplace(a->getId(), A.size());
+  A.push_back(a);
+  a->updateHist();
+}
+
+void Problem::removeAgent(Agent* a) {
+  auto itr = agentIndex.find(a->getId());
+  if (itr == agentIndex.end()) {
+    std::cout << "error@Problem::removeAgent, agent "
+              << a->getId() << " does not exist" << "\n";
+    std::exit(1);
+  }
+  int i = itr->second;
+  agentIndex.erase(itr);
+  if (i != A.size() - 1) {
+    A[i] = A[A.size() - 1];
+    agentIndex.at(A[i]->getId()) = i;
+  }
+  A.pop_back();
+
+  Task* tau = a->getTask();
+  a->releaseTask();
+  if (tau != nullptr) dropTask(tau);
 }
 
 std::string Problem::logStr() {
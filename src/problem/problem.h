@@ -16,10 +16,22 @@ protected:
   Agents A;
   std::vector<Task*> T_OPEN;   // open tasks
   std::vector<Task*> T_CLOSE;  // close tasks
+  std::unordered_map<int, Task*> T_DROP;  // task id -> unfinished task of a removed agent
+  std::unordered_map<int, int> agentIndex;  // agent id -> index of A
+  std::unordered_map<int, int> openIndex;   // task id -> index of T_OPEN
+  std::unordered_map<int, int> closeIndex;  // task id -> index of T_CLOSE, assigned ones
+  int openStamp;  // incremented whenever T_OPEN changes
 
   std::mt19937* MT;
 
   void init();
+  void openTask(Task* tau);     // -> T_OPEN, O(1)
+  bool removeOpen(Task* tau);   // the last task of T_OPEN takes the place
+  void closeTask(Task* tau);    // T_OPEN -> T_CLOSE, O(1)
+  void reopenTask(Task* tau);   // T_CLOSE -> T_OPEN, O(1)
+  void discardTask(Task* tau);  // T_OPEN -> T_DROP, never counted as completed
+  // task of a removed agent, returned to T_OPEN from scratch by default
+  virtual void dropTask(Task* tau);
 
 public:
   Problem(Graph* _G, Agents _A, std::vector<Task*> _T);
@@ -35,7 +47,8 @@ public:
 
   Graph* getG() { return G; }
   Agents getA() { return A; }
-  std::vector<Task*> getT() { return T_OPEN; }
+  const std::vector<Task*>& getT() { return T_OPEN; }
+  int getOpenStamp() { return openStamp; }
   int getTerminationTime() { return timestep; }
   int getTimestep() { return timestep; }
 
@@ -43,6 +56,12 @@ public:
   void setTimestepLimit(int _t) { timesteplimit = _t; }
 
   void assign(Task* tau);
+
+  // add or remove agents between timesteps, O(1)
+  // the last agent of A takes the place of the removed one,
+  // the removed agent is not deleted
+  virtual void addAgent(Agent* a);
+  virtual void removeAgent(Agent* a);
   virtual void setAutoAssignement(bool flg) {}
 
   // for visualization
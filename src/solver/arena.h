@@ -0,0 +1,51 @@
+/*
+ * arena.h
+ *
+ * Purpose: monotonic allocation of objects which are released at once
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+template <class T>
+class Arena {
+private:
+  static const int CHUNK = 256;
+  std::vector<T*> chunks;  // raw storage, kept after release
+  int used;                // number of constructed objects
+  int peak;                // max of used
+
+public:
+  Arena() : used(0), peak(0) {}
+  ~Arena() {
+    release();
+    for (auto chunk : chunks) ::operator delete(chunk);
+  }
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  T* create(T&& obj) {
+    if (used == chunks.size() * CHUNK) {
+      chunks.push_back(static_cast<T*>(::operator new(sizeof(T) * CHUNK)));
+    }
+    T* p = chunks[used / CHUNK] + used % CHUNK;
+    new (p) T(std::move(obj));
+    ++used;
+    peak = std::max(peak, used);
+    return p;
+  }
+
+  // destroy all objects, storage is reused
+  void release() {
+    for (int i = 0; i < used; ++i) chunks[i / CHUNK][i % CHUNK].~T();
+    used = 0;
+  }
+
+  int size() { return used; }
+  size_t getPeakBytes() { return (size_t)peak * sizeof(T); }
+};
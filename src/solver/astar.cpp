@@ -0,0 +1,52 @@
+/*
+ * astar.cpp
+ *
+ * Purpose: space-time A* shared by path planners
+ */
+
+#include "astar.h"
+#include <algorithm>
+
+
+SpaceTimeAstar::SpaceTimeAstar() : used(0), peak(0), focalCnt(0), fmin(0) {}
+
+SpaceTimeAstar::~SpaceTimeAstar() {
+  for (auto chunk : chunks) delete [] chunk;
+}
+
+void SpaceTimeAstar::reset() {
+  used = 0;
+  OPEN.clear();
+  FOCAL.clear();
+  table.clear();
+  fmin = 0;
+}
+
+AN* SpaceTimeAstar::create(Node* v, int g, int f, AN* p) {
+  if (used == chunks.size() * CHUNK) chunks.push_back(new AN[CHUNK]);
+  AN* n = &chunks[used / CHUNK][used % CHUNK];
+  ++used;
+  if (used > peak) peak = used;
+  *n = { v, g, f, p };
+  return n;
+}
+
+SpaceTimeAstar::Entry* SpaceTimeAstar::open(AN* n) {
+  Entry& e = table[getKey(n)];
+  e.node = n;
+  e.handle = OPEN.push(Fib_AN(n));
+  e.h = 0;
+  e.focalStamp = -1;
+  e.closed = false;
+  return &e;
+}
+
+Nodes SpaceTimeAstar::getPath(AN* n) {
+  Nodes path;
+  while (n != nullptr) {
+    path.push_back(n->v);
+    n = n->p;
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
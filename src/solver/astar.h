@@ -0,0 +1,239 @@
+/*
+ * astar.h
+ *
+ * Purpose: space-time A* shared by path planners
+ *
+ * Search nodes are AN, allocated from a pool which is reset per search,
+ * and identified by a packed 64-bit key of (time, node index).
+ * Problem-specific parts are given as functors,
+ *   isGoal(AN* n) -> bool
+ *   shortcut(AN*& n) -> bool, extend n by append() to a goal if possible
+ *   isValid(AN* n, Node* m, int t) -> bool, whether n -> m at t is allowed
+ *   getF(AN* n, Node* m, int t) -> int, f-value of m at t reached from n
+ * and, for focal search,
+ *   getH(AN* n, Node* m, int t) -> int, increment of the primary key in FOCAL
+ *     by n -> m at t, e.g., number of conflicts, summed along the path
+ *   getTie(AN* n) -> float, secondary key in FOCAL
+ */
+
+#pragma once
+
+#include "../graph/graph.h"
+#include <boost/heap/fibonacci_heap.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+struct Fib_FN_ST {  // node in FOCAL
+  Fib_FN_ST(AN* _node, int _h, float _tie) : node(_node), h(_h), tie(_tie) {}
+  AN* node;
+  int h;
+  float tie;
+
+  bool operator<(const Fib_FN_ST& other) const {
+    if (h != other.h) return h > other.h;
+    if (tie != other.tie) return tie > other.tie;
+    return node->g < other.node->g;
+  }
+};
+
+class SpaceTimeAstar {
+private:
+  using OpenHeap = boost::heap::fibonacci_heap<Fib_AN>;
+  using FocalHeap = boost::heap::fibonacci_heap<Fib_FN_ST>;
+
+  struct Entry {
+    AN* node;
+    OpenHeap::handle_type handle;
+    FocalHeap::handle_type handleF;
+    int h;           // value for FOCAL
+    int focalStamp;  // in FOCAL when equal to focalCnt
+    bool closed;
+  };
+
+  static const int CHUNK = 1024;
+  std::vector<AN*> chunks;  // pool
+  int used;                 // number of used nodes in the pool
+  int peak;                 // max of used
+
+  OpenHeap OPEN;
+  FocalHeap FOCAL;
+  std::unordered_map<uint64_t, Entry> table;  // (t, v) -> entry
+  int focalCnt;
+  int fmin;  // f-value of the head of OPEN when FOCAL was last built
+
+  void reset();
+  AN* create(Node* v, int g, int f, AN* p);
+  Entry* open(AN* n);
+
+public:
+  SpaceTimeAstar();
+  ~SpaceTimeAstar();
+
+  static uint64_t getKey(int t, Node* v) {
+    return ((uint64_t)(uint32_t)t << 32) | (uint32_t)v->getIndex();
+  }
+  static uint64_t getKey(AN* n) { return getKey(n->g, n->v); }
+
+  // successor of n at v, used by shortcuts
+  AN* append(AN* n, Node* v) { return create(v, n->g + 1, 0, n); }
+  static Nodes getPath(AN* n);
+  int getFmin() { return fmin; }
+  size_t getPeakBytes() { return (size_t)peak * sizeof(AN); }
+
+  // nodes are valid until the next search, nullptr -> failed
+  template <class IsGoal, class Shortcut, class IsValid, class GetF>
+  AN* search(Graph* G, Node* s, int t, int f,
+             IsGoal isGoal, Shortcut shortcut, IsValid isValid, GetF getF);
+
+  template <class IsGoal, class IsValid, class GetF, class GetH, class GetTie>
+  AN* searchFocal(Graph* G, Node* s, int t, int f, float w,
+                  IsGoal isGoal, IsValid isValid, GetF getF,
+                  GetH getH, GetTie getTie);
+};
+
+template <class IsGoal, class Shortcut, class IsValid, class GetF>
+AN* SpaceTimeAstar::search(Graph* G, Node* s, int t, int f,
+                           IsGoal isGoal, Shortcut shortcut,
+                           IsValid isValid, GetF getF)
+{
+  reset();
+  open(create(s, t, f, nullptr));
+
+  AN* n;
+  while (!OPEN.empty()) {
+    // argmin
+    n = OPEN.top().node;
+
+    if (isGoal(n)) return n;
+    if (shortcut(n)) return n;
+
+    // update list
+    OPEN.pop();
+    table.at(getKey(n)).closed = true;
+
+    // search neighbor
+    Nodes C = G->neighbor(n->v);
+    C.push_back(n->v);
+
+    for (auto m : C) {
+      int g = n->g + 1;
+      auto itr = table.find(getKey(g, m));
+      if (itr != table.end() && itr->second.closed) continue;
+      if (!isValid(n, m, g)) continue;
+      int _f = getF(n, m, g);
+
+      if (itr == table.end()) {  // new node
+        open(create(m, g, _f, n));
+      } else {
+        AN* l = itr->second.node;
+        if (l->f > _f) {
+          l->f = _f;
+          l->p = n;
+          OPEN.increase(itr->second.handle);
+        }
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+template <class IsGoal, class IsValid, class GetF, class GetH, class GetTie>
+AN* SpaceTimeAstar::searchFocal(Graph* G, Node* s, int t, int f, float w,
+                                IsGoal isGoal, IsValid isValid, GetF getF,
+                                GetH getH, GetTie getTie)
+{
+  reset();
+  open(create(s, t, f, nullptr))->h = 0;
+
+  AN* n;
+  uint64_t keyM = 0;
+  float ub = 0;
+  bool updateMin = true;
+
+  while (!OPEN.empty()) {
+    if (updateMin || FOCAL.empty()) {
+      // argmin, closed nodes are removed lazily
+      while (!OPEN.empty() && table.at(getKey(OPEN.top().node)).closed) {
+        OPEN.pop();
+      }
+      if (OPEN.empty()) break;
+      n = OPEN.top().node;
+      fmin = n->f;
+      keyM = getKey(n);
+      ub = n->f * w;
+
+      // rebuild FOCAL
+      FOCAL.clear();
+      ++focalCnt;
+      for (auto itr = OPEN.ordered_begin(); itr != OPEN.ordered_end(); ++itr) {
+        AN* l = (*itr).node;
+        if ((float)l->f > ub) break;
+        Entry& e = table.at(getKey(l));
+        if (e.closed) continue;
+        e.handleF = FOCAL.push(Fib_FN_ST(l, e.h, getTie(l)));
+        e.focalStamp = focalCnt;
+      }
+    }
+
+    // argmin in FOCAL
+    n = FOCAL.top().node;
+    FOCAL.pop();
+    uint64_t key = getKey(n);
+    Entry& entry = table.at(key);
+    int hN = entry.h;
+
+    // already explored
+    if (entry.closed) continue;
+
+    if (isGoal(n)) return n;
+
+    // update list
+    updateMin = (key == keyM);
+    entry.closed = true;
+
+    // search neighbor
+    Nodes C = G->neighbor(n->v);
+    C.push_back(n->v);
+
+    for (auto m : C) {
+      int g = n->g + 1;
+      auto itr = table.find(getKey(g, m));
+      if (itr != table.end() && itr->second.closed) continue;
+      if (!isValid(n, m, g)) continue;
+      int _f = getF(n, m, g);
+
+      Entry* e;
+      bool updateH = false;
+      if (itr == table.end()) {  // new node
+        e = open(create(m, g, _f, n));
+        e->h = hN + getH(n, m, g);
+      } else {
+        e = &(itr->second);
+        AN* l = e->node;
+        if (l->f > _f) {
+          l->f = _f;
+          l->p = n;
+          e->h = hN + getH(n, m, g);
+          OPEN.increase(e->handle);
+          updateH = true;
+        }
+      }
+
+      if (_f <= ub) {
+        if (e->focalStamp != focalCnt) {
+          e->handleF = FOCAL.push(Fib_FN_ST(e->node, e->h, getTie(e->node)));
+          e->focalStamp = focalCnt;
+        } else if (updateH) {
+          (*e->handleF).h = e->h;
+          (*e->handleF).tie = getTie(e->node);
+          FOCAL.increase(e->handleF);
+        }
+      }
+    }
+  }
+
+  return nullptr;
+}
@@ -12,13 +12,16 @@
 
 #include "cbs.h"
 #include <numeric>
+#include <queue>
 #include "../util/util.h"
 
 
-CBS::CBS(Problem* _P) : Solver(_P), ID(false) {
+CBS::CBS(Problem* _P)
+  : Solver(_P), ID(false), detector(G->getNodesNum()) {
   init();
 }
-CBS::CBS(Problem* _P, bool _ID) : Solver(_P), ID(_ID) {
+CBS::CBS(Problem* _P, bool _ID)
+  : Solver(_P), ID(_ID), detector(G->getNodesNum()) {
   init();
 }
 
@@ -26,6 +29,26 @@ CBS::~CBS() {}
 
 void CBS::init() {
   G->setRegFlg(true);
+  pool.reset(new ThreadPool(1));
+  astars.emplace_back();
+  cats.emplace_back(G->getNodesNum());
+  bypass = false;
+  bypassCnt = 0;
+  cardinal = false;
+  mddStamp.assign(G->getNodesNum(), 0);
+  mddStampCnt = 0;
+}
+
+void CBS::setThreads(int num) {
+  if (num < 1) {
+    std::cout << "error@CBS::setThreads, invalid number, " << num << "\n";
+    std::exit(1);
+  }
+  pool.reset(new ThreadPool(num));
+  while (astars.size() < num) astars.emplace_back();
+  while (cats.size() < num) cats.emplace_back(G->getNodesNum());
+  G->setLockFlg(num > 1);
+  lockDists = (num > 1);
 }
 
 bool CBS::solve() {
@@ -144,46 +167,68 @@ bool CBS::checkAgents(Paths& paths, std::vector<Agents>& whole) {
   return checkAll;
 }
 
+// OPEN of CT nodes, cost -> collisions -> generated order
+struct OpenCTNode {
+  CTNode* node;
+  int order;
+
+  bool operator<(const OpenCTNode& other) const {
+    if (node->cost != other.node->cost) return node->cost > other.node->cost;
+    if (node->collisions != other.node->collisions) {
+      return node->collisions > other.node->collisions;
+    }
+    return order > other.order;
+  }
+};
+
 bool CBS::solvePart(Paths& paths, Agents& block) {
   CTNode* node;
   Constraints constraints;
-  std::vector<CTNode*> OPEN, ALL;
+  std::priority_queue<OpenCTNode> OPEN;
+  std::vector<CTNode*> ALL;
   bool status = true;
+  int order = 0;
 
-  CTNode* root = new CTNode { {}, {}, 0, nullptr, true, {}, 0 };
-  invoke(root, block);
-  OPEN.push_back(root);
-  ALL.push_back(root);
   bool CAT = std::any_of(paths.begin(), paths.end(),
                          [](Nodes p) { return !p.empty(); });
+  CTNode* root = ctNodes.create({ {}, {}, 0, nullptr, true, {}, 0, 0 });
+  invoke(root, block);
+  if (CAT) root->collisions = countCollisions(root, paths);
+  OPEN.push({ root, order++ });
+  ALL.push_back(root);
 
   while (!OPEN.empty()) {
-    auto itr = std::min_element(OPEN.begin(), OPEN.end(),
-                                [CAT, this, &paths]
-                                (CTNode* n1, CTNode* n2) {
-                                  if (CAT && n1->cost == n2->cost) {
-                                    int c1 = this->countCollisions(n1, paths);
-                                    int c2 = this->countCollisions(n2, paths);
-                                    return c1 < c2;
-                                  }
-                                  return n1->cost < n2->cost;
-                                });
-    node = *itr;
+    OpenCTNode top = OPEN.top();
+    node = top.node;
     constraints = valid(node, block);
     if (constraints.empty()) break;
-    OPEN.erase(itr);
+    OPEN.pop();
 
+    std::vector<CTNode*> children;
     for (auto constraint : constraints) {
-      CTNode* newNode = new CTNode { constraint, node->paths,
-                                     0, node, true,
-                                     {}, 0 };
+      children.push_back(ctNodes.create({ constraint, node->paths,
+                                          0, node, true,
+                                          {}, 0, 0 }));
+    }
 
-      // it works, but it is late
-      // if (isDuplicatedCTNode(newNode, ALL)) continue;
+    // it works, but it is late
+    // if (isDuplicatedCTNode(newNode, ALL)) continue;
 
-      invoke(newNode, block);
+    // planned in parallel, inserted in order
+    pool->run(children.size(), [&](int k) { invoke(children[k], block); });
+
+    // expand the same node again
+    if (bypass && bypassChild(node, countConflicts(node->paths), children)) {
+      if (CAT) node->collisions = countCollisions(node, paths);
+      OPEN.push(top);
+      constraints.clear();
+      continue;
+    }
+
+    for (auto newNode : children) {
       if (newNode->valid) {
-        OPEN.push_back(newNode);
+        if (CAT) newNode->collisions = countCollisions(newNode, paths);
+        OPEN.push({ newNode, order++ });
         ALL.push_back(newNode);
       }
     }
@@ -192,175 +237,283 @@ bool CBS::solvePart(Paths& paths, Agents& block) {
 
   if (!OPEN.empty()) {  // sucssess
     for (int i = 0; i < paths.size(); ++i) {
-      if (!node->paths[i].empty()) {
-        paths[i] = node->paths[i];
-      }
+      if (node->paths[i]) paths[i] = *node->paths[i];
     }
     status = status && true;
   } else {
     status = false;
   }
+  releaseBlock();
 
   return status;
 }
 
+void CBS::releaseBlock() {
+  ctNodes.release();
+  conflicts.release();
+  knownPaths.clear();
+  mdds.clear();
+}
+
 int CBS::countCollisions(CTNode* c, Paths& paths) {
-  int collision = 0;
-  for (auto p1 : paths) {
-    if (p1.empty()) continue;
-    for (auto p2 : c->paths) {
-      if (p2.empty() || p1[0] == p2[0]) continue;
-      for (int t = 0; t < p1.size(); ++t) {
-        if (p2.size() < t) {
-          if (p1[t] == p2[p2.size() - 1]) ++collision;
-          continue;
-        }
-        if (p1[t] == p2[t]) {
-          ++collision;
-          continue;
-        }
-        if (t > 0 && p1[t-1] == p2[t] && p1[t] == p2[t-2]) {
-          ++collision;
-          continue;
-        }
-      }
+  detector.clear();
+  for (int i = 0; i < paths.size(); ++i) {
+    if (c->paths[i]) {
+      detector.add(i, *c->paths[i]);
+    } else {
+      detector.add(i, paths[i], true);
     }
   }
+  return detector.countCollisions();
+}
 
-  return collision;
+// number of pairs of colliding agents
+int CBS::countConflicts(CTPaths& paths) {
+  detector.clear();
+  for (int i = 0; i < paths.size(); ++i) {
+    if (paths[i]) detector.add(i, *paths[i]);
+  }
+  return detector.countPairs();
 }
 
+// the first child with no more cost and fewer conflicts gives its paths
+bool CBS::bypassChild(CTNode* node, int conflictNum,
+                      std::vector<CTNode*>& children) {
+  auto itr = std::find_if(children.begin(), children.end(),
+                          [&] (CTNode* c) {
+                            return c->valid && c->cost <= node->cost
+                              && countConflicts(c->paths) < conflictNum; });
+  if (itr == children.end()) return false;
+  node->paths = (*itr)->paths;
+  node->cost = (*itr)->cost;
+  node->conflictPairs = (*itr)->conflictPairs;
+  ++bypassCnt;
+  return true;
+}
+
+// without trailing stays at the goal
+CTPath CBS::makeCTPath(const Nodes& path) {
+  if (path.empty()) return nullptr;
+  int size = path.size();
+  while (size > 1 && path[size-2] == path[size-1]) --size;
+  return std::make_shared<const Nodes>(path.begin(), path.begin() + size);
+}
+
+Node* CBS::getNodeAt(const Nodes& path, int t) {
+  if (t >= path.size()) return path.back();
+  return path[t];
+}
+
+int CBS::getMaxLength(CTPaths& paths) {
+  int maxLength = 0;
+  for (auto& p : paths) {
+    if (p && p->size() > maxLength) maxLength = p->size();
+  }
+  return maxLength;
+}
+
+// paths are indexed by agent id, nullptr -> no path
 void CBS::invoke(CTNode* node, Agents& block) {
   // calc path
   if (node->c.empty()) {  // initail
-    Paths paths;
-    for (int i = 0; i < A.size(); ++i) paths.push_back({});
-    for (auto a : block) {
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      paths[std::distance(A.begin(), itr)] = AstarSearch(a, node);
-    }
-    node->paths = paths;
+    node->paths = CTPaths(A.size(), nullptr);
+    pool->run(block.size(), [&](int k) {
+        Agent* a = block[k];
+        node->paths[a->getId()] = makeCTPath(AstarSearch(a, node));
+      });
   } else {
-    Agent* a;
-    for (auto c : node->c) {
-      a = c->a;
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      node->paths[std::distance(A.begin(), itr)].clear();
-    }
+    for (auto c : node->c) node->paths[c->a->getId()] = nullptr;
     for (auto c : node->c) {
-      a = c->a;
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      node->paths[std::distance(A.begin(), itr)] = AstarSearch(a, node);
+      node->paths[c->a->getId()] = makeCTPath(AstarSearch(c->a, node));
     }
   }
+  // reduced here, searches run in parallel
+  for (auto a : block) {
+    if (!node->paths[a->getId()]) node->valid = false;
+  }
   if (!node->valid) return;
   calcCost(node, block);
-  formalizePathAgents(node, block);
 }
 
 void CBS::calcCost(CTNode* node, Agents& block) {
   int cost = 0;
   Node* g;
-  Nodes path;
+  int k;
   for (auto a : block) {
-    auto itr1 = std::find_if(A.begin(), A.end(),
-                            [a](Agent* b) { return a == b; });
     g = a->getGoal();
-    path = node->paths[std::distance(A.begin(), itr1)];
-    auto itr2 = path.end() - 1;
-    while (g == *itr2) --itr2;
-    cost += std::distance(path.begin(), itr2);
+    const Nodes& path = *node->paths[a->getId()];
+    k = path.size() - 1;
+    while (k >= 0 && g == path[k]) --k;
+    cost += k;
   }
   node->cost = cost;
 }
 
 Constraints CBS::valid(CTNode* node, Agents& block) {
-  Paths paths = node->paths;
-  int maxLength = node->paths[0].size();
+  CTPaths& paths = node->paths;
   Constraints constraints = {};
-  std::vector<int> ids;
-  Node* v;
-  Agent *a, *b;
-  int i, j;
 
-  for (int t = 1; t < maxLength; ++t) {
-    for (int _i = 0; _i < block.size(); ++_i) {
-      a = block[_i];
-      auto itr1 = std::find_if(A.begin(), A.end(),
-                               [a](Agent* _a)
-                               { return a->getId() == _a->getId(); });
-      i = std::distance(A.begin(), itr1);
-      v = paths[i][t];
-
-      // check collision
-      ids.clear();
-      for (int _j = _i + 1; _j < block.size(); ++_j) {
-        b = block[_j];
-        auto itr2 = std::find_if(A.begin(), A.end(),
-                                 [b](Agent* _b) { return b == _b; });
-        j = std::distance(A.begin(), itr2);
-        if (paths[j][t] == v) ids.push_back(j);
-      }
+  detector.clear();
+  for (auto a : block) detector.add(a->getId(), *paths[a->getId()]);
+  ConflictDetector::Collision col;
+  if (cardinal) {
+    if (!findCardinal(node, col)) return constraints;
+  } else {
+    if (!detector.findFirst(col)) return constraints;
+  }
 
-      if (!ids.empty()) {  // detect collision
-        ids.push_back(i);
-        for (int k = 0; k < ids.size(); ++k) {
-          Constraint constraint;
-          for (int l = 0; l < ids.size(); ++l) {
-            if (k == l) continue;
-            Conflict* c = new Conflict { A[ids[l]], t, v, v, true, "" };
-            setCKey(c);
-            constraint.push_back(c);
-          }
-          constraints.push_back(constraint);
+  int t = col.t;
+  int i = col.i;
+  int j = col.j;
+  if (col.onNode) {  // detect collision
+    Node* v = getNodeAt(*paths[i], t);
+    std::vector<int> ids;
+    if (cardinal) {  // only the pair
+      ids.push_back(j);
+    } else {
+      auto itr = std::find(block.begin(), block.end(), A[i]);
+      for (++itr; itr != block.end(); ++itr) {
+        if (getNodeAt(*paths[(*itr)->getId()], t) == v) {
+          ids.push_back((*itr)->getId());
         }
-        return constraints;
       }
-
-      // check intersection
-      auto itr3 = paths.begin() + i;
-      auto itr4 = std::find_if(itr3 + 1, paths.end(),
-                               [t, itr3](Nodes path) {
-                                 if (path.empty()) return false;
-                                 return (path[t] == (*itr3)[t-1])
-                                   && (path[t-1] == (*itr3)[t]); });
-      if (itr4 != paths.end()) {  // detect intersection
-
-        Constraint knownConstraint = getConstraints(node);
-
-        j = std::distance(paths.begin(), itr4);
-        Conflict* c1 = new Conflict { A[i], t, (*itr3)[t], (*itr3)[t-1], false, "" };
-        Conflict* c2 = new Conflict { A[j], t, (*itr4)[t], (*itr4)[t-1], false, "" };
-        setCKey(c1);
-        setCKey(c2);
-        constraints.push_back({ c1 });
-        constraints.push_back({ c2 });
-        return constraints;
+    }
+    ids.push_back(i);
+    for (int k = 0; k < ids.size(); ++k) {
+      Constraint constraint;
+      for (int l = 0; l < ids.size(); ++l) {
+        if (k == l) continue;
+        Conflict* c = conflicts.create({ A[ids[l]], t, v, v, true, 0 });
+        setCKey(c);
+        constraint.push_back(c);
       }
+      constraints.push_back(constraint);
     }
+
+  } else {  // detect intersection
+    const Nodes& p1 = *paths[i];
+    const Nodes& p2 = *paths[j];
+    Conflict* c1 = conflicts.create({ A[i], t, getNodeAt(p1, t),
+                                      getNodeAt(p1, t-1), false, 0 });
+    Conflict* c2 = conflicts.create({ A[j], t, getNodeAt(p2, t),
+                                      getNodeAt(p2, t-1), false, 0 });
+    setCKey(c1);
+    setCKey(c2);
+    constraints.push_back({ c1 });
+    constraints.push_back({ c2 });
   }
 
   return constraints;
 }
 
-void CBS::formalizePathAgents(CTNode* node, Agents& block) {
-  int maxLength = getMaxLengthPaths(node->paths);
-  Node* g;
-  int i;
-  for (auto a : block) {
-    auto itr = std::find_if(A.begin(), A.end(),
-                            [a](Agent* b) { return a == b; });
-    i = std::distance(A.begin(), itr);
-    g = node->paths[i][node->paths[i].size() - 1];
-    while (node->paths[i].size() != maxLength) node->paths[i].push_back(g);
+// cardinal, then semi-cardinal, then non-cardinal, in order of time
+bool CBS::findCardinal(CTNode* node, ConflictDetector::Collision& col) {
+  std::vector<ConflictDetector::Collision> cols;
+  detector.findAll(cols);
+  if (cols.empty()) return false;
+
+  int best = -1;
+  for (auto& c : cols) {
+    int k = isCardinal(node, c.i, c.t, c.onNode)
+      + isCardinal(node, c.j, c.t, c.onNode);
+    if (k > best) {
+      best = k;
+      col = c;
+      if (best == 2) break;
+    }
+  }
+  return true;
+}
+
+// whether the agent cannot avoid the conflict without increasing its cost
+bool CBS::isCardinal(CTNode* node, int id, int t, bool onNode) {
+  const MDD& mdd = getMDD(node, A[id]);
+  if (mdd.empty()) return false;
+  int last = mdd.size() - 1;
+  if (mdd[std::min(t, last)] != 1) return false;
+  return onNode || mdd[std::min(t-1, last)] == 1;
+}
+
+const CBS::MDD& CBS::getMDD(CTNode* node, Agent* a) {
+  Constraint constraints = getConstraintsForAgent(node, a);
+  int cost = node->paths[a->getId()]->size() - 1;
+  uint64_t key = getCKey(a->getNode(), a->getGoal(), constraints)
+    ^ mixKey(cost);
+  auto itr = mdds.find(key);
+  if (itr != mdds.end()) return itr->second;
+  return mdds.emplace(key, buildMDD(a, constraints, cost)).first->second;
+}
+
+// nodes on paths of the cost satisfying the constraints,
+// pruned by the distance field of the goal
+CBS::MDD CBS::buildMDD(Agent* a, Constraint& constraints, int cost) {
+  Node* s = a->getNode();
+  Node* g = a->getGoal();
+  const std::vector<int>& field = goalField(g);
+  std::vector<Nodes> levels(cost + 1);
+  Nodes C;
+
+  // forward
+  levels[0].push_back(s);
+  for (int t = 1; t <= cost; ++t) {
+    ++mddStampCnt;
+    for (auto u : levels[t-1]) {
+      C = G->neighbor(u);
+      C.push_back(u);
+      for (auto v : C) {
+        int k = v->getIndex();
+        if (mddStamp[k] == mddStampCnt) continue;
+        if (t + field[k] > cost) continue;
+        if (isConstrained(a, constraints, u, v, t)) continue;
+        mddStamp[k] = mddStampCnt;
+        levels[t].push_back(v);
+      }
+    }
+  }
+  if (std::find(levels[cost].begin(), levels[cost].end(), g)
+      == levels[cost].end()) {
+    return {};
+  }
+
+  // backward, remove dead ends
+  MDD mdd(cost + 1, 0);
+  levels[cost] = { g };
+  mdd[cost] = 1;
+  ++mddStampCnt;
+  mddStamp[g->getIndex()] = mddStampCnt;
+  for (int t = cost - 1; t >= 0; --t) {
+    Nodes kept;
+    for (auto u : levels[t]) {
+      C = G->neighbor(u);
+      C.push_back(u);
+      for (auto v : C) {
+        if (mddStamp[v->getIndex()] == mddStampCnt
+            && !isConstrained(a, constraints, u, v, t + 1)) {
+          kept.push_back(u);
+          break;
+        }
+      }
+    }
+    ++mddStampCnt;
+    for (auto u : kept) mddStamp[u->getIndex()] = mddStampCnt;
+    mdd[t] = kept.size();
   }
+  return mdd;
+}
+
+// moving from u at t-1 to v at t is prohibited or not
+bool CBS::isConstrained(Agent* a, Constraint& constraints,
+                        Node* u, Node* v, int t) {
+  return std::any_of(constraints.begin(), constraints.end(),
+                     [a, u, v, t] (Conflict* c) {
+                       if (c->a != a || c->t != t || c->v != v) return false;
+                       return c->onNode || c->u == u;
+                     });
 }
 
 Nodes CBS::AstarSearch(Agent* a, CTNode* node) {
   Constraint constraints = getConstraintsForAgent(node, a);
+  SpaceTimeAstar& astar = getAstar();
 
   Node* _s = a->getNode();
   Node* _g = a->getGoal();
@@ -369,24 +522,18 @@ Nodes CBS::AstarSearch(Agent* a, CTNode* node) {
   // constraint free
   if (constraints.empty()) return G->getPath(_s, _g);
 
-  // know path
-  std::string cKey = getCKey(_s, _g, constraints);
-  auto itrK = knownPaths.find(cKey);
-  if (itrK != knownPaths.end()) {
-    if (itrK->second.empty()) node->valid = false;
-    return itrK->second;
-  }
-
-  // previously computed path
-  std::string dKey = cKey;
-  if (!constraints.empty()) {
-    while (*(dKey.end()-1) != '-') dKey.erase(dKey.end()-1);
-    dKey.erase(dKey.end()-1);
-  }
+  uint64_t cKey = getCKey(_s, _g, constraints);
   Nodes dPath;
-  itrK = knownPaths.find(dKey);
-  if (itrK != knownPaths.end()) {
-    dPath = itrK->second;
+  {
+    std::lock_guard<std::mutex> lock(knownPathsMtx);
+
+    // know path
+    auto itrK = knownPaths.find(cKey);
+    if (itrK != knownPaths.end()) return itrK->second;
+
+    // previously computed path, without the oldest constraint
+    itrK = knownPaths.find(cKey ^ constraints.back()->key);
+    if (itrK != knownPaths.end()) dPath = itrK->second;
   }
 
   // goal condition
@@ -400,119 +547,57 @@ Nodes CBS::AstarSearch(Agent* a, CTNode* node) {
   }
   // =============================
 
-  Nodes path, tmpPath, C;
-  int f, g;
-  std::string key;
-  bool invalid = true;  // success or not
-
-  boost::heap::fibonacci_heap<Fib_AN> OPEN;
-  std::unordered_map<std::string, boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
-  std::unordered_set<std::string> CLOSE;  // key
-  AN* n = new AN { _s, 0, pathDist(_s, _g), nullptr };
-  auto handle = OPEN.push(Fib_AN(n));
-  key = getKey(n);
-  SEARCHED.emplace(key, handle);
-
-  while (!OPEN.empty()) {
-    // argmin
-    n = OPEN.top().node;
+  Nodes path, tmpPath;
 
+  AN* n = astar.search(
+    G, _s, 0, pathDist(_s, _g),
     // check goal condtion
-    if (n->v == _g) {
-      if (!existGoalConstraint || timeGoalConstraint < n->g) {
-        invalid = false;
-        break;
-      }
-    }
-
+    [&] (AN* n) {
+      return n->v == _g && (!existGoalConstraint || timeGoalConstraint < n->g);
+    },
     // ==== fast implementation ====
-    tmpPath = G->getPath(n->v, _g);
-    if (validShorcut(a, n, _g, constraints, tmpPath)) {
-      for (int i = 1; i < tmpPath.size(); ++i) {
-        n = new AN { tmpPath[i], 0, 0, n };
-      }
-      invalid = false;
-      break;
-    }
-    tmpPath.clear();
-
-    // encount previously explored path
-    if (!dPath.empty() && n->g <= dPath.size() - 1 && n->v == dPath[n->g]) {
-      tmpPath = dPath;
-      for (int i = 0; i < n->g; ++i) tmpPath.erase(tmpPath.begin());
+    [&] (AN*& n) {
+      tmpPath = G->getPath(n->v, _g);
       if (validShorcut(a, n, _g, constraints, tmpPath)) {
-        for (int i = 1; i < tmpPath.size(); ++i) {
-          n = new AN { tmpPath[i], 0, 0, n };
+        for (int i = 1; i < tmpPath.size(); ++i) n = astar.append(n, tmpPath[i]);
+        return true;
+      }
+      // encount previously explored path
+      if (!dPath.empty() && n->g <= dPath.size() - 1 && n->v == dPath[n->g]) {
+        tmpPath.assign(dPath.begin() + n->g, dPath.end());
+        if (validShorcut(a, n, _g, constraints, tmpPath)) {
+          for (int i = 1; i < tmpPath.size(); ++i) n = astar.append(n, tmpPath[i]);
+          return true;
         }
-        invalid = false;
-        break;
       }
-    }
+      return false;
+    },
     // =============================
-
-    // update list
-    OPEN.pop();
-    CLOSE.emplace(getKey(n));
-
-    // search neighbor
-    C = G->neighbor(n->v);
-    C.push_back(n->v);
-
-    for (auto m : C) {
-      g = n->g + 1;
-      key = getKey(g, m);
-      if (CLOSE.find(key) != CLOSE.end()) continue;
-
-      // check constraints
-      auto constraint = std::find_if(constraints.begin(), constraints.end(),
-                                     [a, g, m, n] (Conflict* c) {
-                                       if (c->a != a) return false;
-                                       if (c->t != g) return false;
-                                       if (c->onNode) return c->v == m;
-                                       return c->v == m && c->u == n->v;
-                                     });
-      if (constraint != constraints.end()) continue;
-      f = g + pathDist(m, _g);
-
+    // check constraints
+    [&] (AN* n, Node* m, int g) {
+      return std::none_of(constraints.begin(), constraints.end(),
+                          [a, g, m, n] (Conflict* c) {
+                            if (c->a != a) return false;
+                            if (c->t != g) return false;
+                            if (c->onNode) return c->v == m;
+                            return c->v == m && c->u == n->v;
+                          });
+    },
+    [&] (AN* n, Node* m, int g) {
       // ==== fast implementation ====
       if (!dPath.empty() && g <= dPath.size() - 1 && m == dPath[g]) {
-        f = dPath.size() - 1;
+        return (int)dPath.size() - 1;
       }
-      // if (existGoalConstraint) {
-      //   f = pathDist(m, _g) + timeGoalConstraint;
-      // }
       // =============================
+      return g + pathDist(m, _g);
+    });
 
-      auto itrS = SEARCHED.find(key);
-      if (itrS == SEARCHED.end()) {  // new node
-        AN* l = new AN { m, g, f, n };
-        auto handle = OPEN.push(Fib_AN(l));
-        SEARCHED.emplace(key, handle);
-      } else {
-        auto handle = itrS->second;
-        AN* l = (*handle).node;
-        if (l->f > f) {
-          l->g = g;
-          l->f = f;
-          l->p = n;
-        }
-        OPEN.increase(handle);
-      }
-    }
+  if (n != nullptr) path = astar.getPath(n);  // empty -> failed
+  {
+    std::lock_guard<std::mutex> lock(knownPathsMtx);
+    knownPaths.emplace(cKey, path);
   }
 
-  // back tracking
-  if (!invalid) {  // check failed or not
-    while (n != nullptr) {
-      path.push_back(n->v);
-      n = n->p;
-    }
-    std::reverse(path.begin(), path.end());
-  } else {
-    node->valid = false;
-  }
-  knownPaths.emplace(cKey, path);
-
   return path;
 }
 
@@ -622,29 +707,49 @@ bool CBS::validShorcut(Agent* a, AN* n, Node* _g,
   return itrC == constraints.end();
 }
 
-std::string CBS::getCKey(Node* s, Node* g, Constraint &constraints) {
-  std::string key = std::to_string(s->getId()) + "-" + std::to_string(g->getId());
-  for (auto c : constraints) {
-    key += "-" + c->key;
-  }
+// splitmix64
+uint64_t CBS::mixKey(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// independent of the order of constraints
+uint64_t CBS::getCKey(Node* s, Node* g, Constraint &constraints) {
+  uint64_t key = mixKey(((uint64_t)s->getIndex() << 32) | g->getIndex());
+  for (auto c : constraints) key ^= c->key;
   return key;
 }
 
 void CBS::setCKey(Conflict* c) {
-  std::string key = std::to_string(c->a->getId()) + "_";
-  key += std::to_string(c->t) + "_";
-  if (c->onNode) {
-    key += std::to_string(c->v->getId());
-  } else {
-    key += std::to_string(c->v->getId()) + "_" + std::to_string(c->u->getId());
-  }
+  uint64_t key = mixKey(((uint64_t)c->a->getId() << 32) | (uint32_t)c->t);
+  key = mixKey(key ^ c->v->getIndex());
+  if (!c->onNode) key = mixKey(key ^ ((uint64_t)c->u->getIndex() << 32));
   c->key = key;
 }
 
+// peak bytes of arenas
+std::string CBS::arenaLogStr() {
+  std::string str;
+  str += "[solver] arena_ctnode:" + std::to_string(ctNodes.getPeakBytes()) + "\n";
+  str += "[solver] arena_conflict:"
+    + std::to_string(conflicts.getPeakBytes()) + "\n";
+  size_t searchBytes = 0;
+  for (auto& astar : astars) searchBytes += astar.getPeakBytes();
+  str += "[solver] arena_searchnode:" + std::to_string(searchBytes) + "\n";
+  return str;
+}
+
 std::string CBS::logStr() {
   std::string str;
   str += "[solver] type:CBS\n";
   str += "[solver] ID:" + std::to_string(ID) + "\n";
+  str += "[solver] threads:" + std::to_string(pool->size()) + "\n";
+  str += "[solver] cardinal:" + std::to_string(cardinal) + "\n";
+  str += "[solver] bypass:" + std::to_string(bypass) + "\n";
+  str += "[solver] bypass_cnt:" + std::to_string(bypassCnt) + "\n";
+  str += arenaLogStr();
   str += Solver::logStr();
   return str;
 }
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "solver.h"
+#include "astar.h"
+#include "arena.h"
+#include "detector.h"
+#include "../util/threadpool.h"
+#include <deque>
+#include <memory>
+#include <mutex>
 
 struct Conflict {
   Agent* a;  // this agent
@@ -8,34 +15,74 @@ struct Conflict {
   Node* v;   // cannot use v
   Node* u;   // prev
   bool onNode;  // true or false
-  std::string key;
+  uint64_t key;  // hash, xor of keys identifies a set of conflicts
 };
 
 using Constraint = std::vector<Conflict*>;
 using Constraints = std::vector<Constraint>;
 
+// path shared among CT nodes, staying at the goal is implicit
+using CTPath = std::shared_ptr<const Nodes>;
+using CTPaths = std::vector<CTPath>;  // nullptr -> not planned
+
 struct CTNode {  // conflict-tree node
   Constraint c;  // conflicts
-  Paths paths;   // current path
+  CTPaths paths; // current path
   int cost;      // sum of paths
   CTNode* p;     // parent
   bool valid;
 
-  std::vector<int> fmins;  // for ecbs
+  std::vector<int> fmins;  // min f-value of each agent, for ecbs
   int LB;
+  int collisions;  // with paths of other blocks, for tie-breaking
+  std::vector<std::pair<int, int>> conflictPairs;  // sorted ids, for ecbs
 };
 
 
 class CBS : public Solver {
 protected:
   bool ID;  // independent detection
-  std::unordered_map<std::string, Nodes> knownPaths;
+  std::unordered_map<uint64_t, Nodes> knownPaths;  // getCKey -> path
+  std::mutex knownPathsMtx;
+  ConflictDetector detector;
+
+  // adopt a child instead of branching when it is not worse
+  bool bypass;
+  int bypassCnt;
+  bool bypassChild(CTNode* node, int conflictNum,
+                   std::vector<CTNode*>& children);
+
+  // split cardinal conflicts first, judged by MDDs
+  bool cardinal;
+  using MDD = std::vector<int>;  // number of nodes at each timestep
+  std::unordered_map<uint64_t, MDD> mdds;  // getCKey and cost -> MDD
+  std::vector<int> mddStamp;
+  int mddStampCnt;
+  const MDD& getMDD(CTNode* node, Agent* a);
+  MDD buildMDD(Agent* a, Constraint& constraints, int cost);
+  bool isCardinal(CTNode* node, int id, int t, bool onNode);
+  bool findCardinal(CTNode* node, ConflictDetector::Collision& col);
+
+  // low-level searches run on the workers
+  std::unique_ptr<ThreadPool> pool;
+  std::deque<SpaceTimeAstar> astars;  // one per worker
+  SpaceTimeAstar& getAstar() { return astars[ThreadPool::getWorkerId()]; }
+  std::deque<ConflictTable> cats;  // one per worker, for ecbs
+  ConflictTable& getCAT() { return cats[ThreadPool::getWorkerId()]; }
+
+  // released when each block is solved
+  Arena<CTNode> ctNodes;
+  Arena<Conflict> conflicts;
+  void releaseBlock();
+  std::string arenaLogStr();
 
   void init();
   virtual void invoke(CTNode* node, Agents& block);
   Constraints valid(CTNode* node, Agents& block);
   void calcCost(CTNode* node, Agents& block);
-  void formalizePathAgents(CTNode* node, Agents& block);
+  static CTPath makeCTPath(const Nodes& path);
+  static Node* getNodeAt(const Nodes& path, int t);
+  static int getMaxLength(CTPaths& paths);
   virtual Nodes AstarSearch(Agent* a, CTNode* node);
   Constraint getConstraintsForAgent(CTNode* ctNode, Agent* a);
   Constraint getConstraints(CTNode* ctNode);
@@ -45,8 +92,12 @@ protected:
   bool isDuplicatedConflict(Conflict* c1, Conflict* c2);
   bool isDuplicatedCTNode(CTNode* newCT, std::vector<CTNode*> &cts);
   int countCollisions(CTNode* c, Paths& paths);
+  int countConflicts(CTPaths& paths);
+  static uint64_t mixKey(uint64_t x);
   void setCKey(Conflict* c);
-  std::string getCKey(Node* s, Node* g, Constraint &constraints);
+  uint64_t getCKey(Node* s, Node* g, Constraint &constraints);
+  static bool isConstrained(Agent* a, Constraint& constraints,
+                            Node* u, Node* v, int t);
   bool validShorcut(Agent* a, AN* n, Node* g,
                     Constraint &constraints,
                     Nodes &tmpPath);
@@ -57,6 +108,9 @@ public:
   ~CBS();
 
   bool solve();
+  void setThreads(int num);
+  void setCardinal(bool flg) { cardinal = flg; }
+  void setBypass(bool flg) { bypass = flg; }
 
   virtual std::string logStr();
 };
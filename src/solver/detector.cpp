@@ -0,0 +1,234 @@
+/*
+ * detector.cpp
+ *
+ * Purpose: conflict detection among paths by sweeping time once
+ */
+
+#include "detector.h"
+#include <algorithm>
+
+
+ConflictDetector::ConflictDetector(int nodeNum)
+  : maxLength(0), head(nodeNum, -1), stamp(nodeNum, -1), layer(0) {}
+
+void ConflictDetector::clear() {
+  entries.clear();
+  maxLength = 0;
+}
+
+void ConflictDetector::add(int id, const Nodes& path, bool fixed) {
+  if (path.empty()) return;
+  entries.push_back({ id, &path, fixed });
+  if (path.size() > maxLength) maxLength = path.size();
+}
+
+void ConflictDetector::build(int t, bool fixed) {
+  ++layer;
+  next.resize(entries.size());
+  for (int k = entries.size() - 1; k >= 0; --k) {
+    if (entries[k].fixed != fixed) continue;
+    int v = at(entries[k], t)->getIndex();
+    next[k] = (stamp[v] == layer) ? head[v] : -1;
+    head[v] = k;
+    stamp[v] = layer;
+  }
+}
+
+int ConflictDetector::first(Node* v) {
+  int i = v->getIndex();
+  return (stamp[i] == layer) ? head[i] : -1;
+}
+
+bool ConflictDetector::findFirst(Collision& c) {
+  for (int t = 1; t < maxLength; ++t) {
+    build(t, false);
+    for (int s = 0; s < entries.size(); ++s) {
+      Entry& e = entries[s];
+      if (e.fixed) continue;
+      Node* v = at(e, t);
+
+      // vertex, with paths registered later
+      for (int k = first(v); k != -1; k = next[k]) {
+        if (k <= s) continue;
+        c = { t, e.id, entries[k].id, true };
+        return true;
+      }
+
+      // swap
+      Node* u = at(e, t-1);
+      if (u == v) continue;
+      int j = -1;
+      for (int k = first(u); k != -1; k = next[k]) {
+        if (at(entries[k], t-1) != v || entries[k].id <= e.id) continue;
+        if (j == -1 || entries[k].id < j) j = entries[k].id;
+      }
+      if (j != -1) {
+        c = { t, e.id, j, false };
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ConflictDetector::findAll(std::vector<Collision>& cols) {
+  cols.clear();
+  for (int t = 1; t < maxLength; ++t) {
+    build(t, false);
+    for (int s = 0; s < entries.size(); ++s) {
+      Entry& e = entries[s];
+      if (e.fixed) continue;
+      Node* v = at(e, t);
+
+      for (int k = first(v); k != -1; k = next[k]) {
+        if (k <= s) continue;
+        cols.push_back({ t, e.id, entries[k].id, true });
+      }
+
+      Node* u = at(e, t-1);
+      if (u == v) continue;
+      for (int k = first(u); k != -1; k = next[k]) {
+        if (k <= s || at(entries[k], t-1) != v) continue;
+        cols.push_back({ t, e.id, entries[k].id, false });
+      }
+    }
+  }
+}
+
+void ConflictDetector::getPairs(std::vector<std::pair<int, int>>& pairs) {
+  pairs.clear();
+  for (int t = 0; t < maxLength; ++t) {
+    build(t, false);
+    for (int s = 0; s < entries.size(); ++s) {
+      Entry& e = entries[s];
+      if (e.fixed) continue;
+      Node* v = at(e, t);
+
+      for (int k = first(v); k != -1; k = next[k]) {
+        if (k <= s || !inRange(e, entries[k], t)) continue;
+        pairs.push_back(std::minmax(e.id, entries[k].id));
+      }
+
+      if (t == 0) continue;
+      Node* u = at(e, t-1);
+      if (u == v) continue;
+      for (int k = first(u); k != -1; k = next[k]) {
+        if (k <= s || at(entries[k], t-1) != v) continue;
+        pairs.push_back(std::minmax(e.id, entries[k].id));
+      }
+    }
+  }
+
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
+
+int ConflictDetector::countPairs() {
+  std::vector<std::pair<int, int>> pairs;
+  getPairs(pairs);
+  return pairs.size();
+}
+
+int ConflictDetector::countCollisions() {
+  int collision = 0;
+  for (int t = 0; t < maxLength; ++t) {
+    build(t, true);
+    for (auto& e : entries) {
+      if (e.fixed) continue;
+      Node* v = at(e, t);
+
+      for (int k = first(v); k != -1; k = next[k]) {
+        if (inRange(e, entries[k], t)) ++collision;
+      }
+
+      // staying agents never swap
+      if (t == 0) continue;
+      Node* u = at(e, t-1);
+      if (u == v) continue;
+      for (int k = first(u); k != -1; k = next[k]) {
+        if (at(entries[k], t-1) == v) ++collision;
+      }
+    }
+  }
+  return collision;
+}
+
+ConflictTable::ConflictTable(int _nodeNum)
+  : nodeNum(_nodeNum), maxLength(0), stays(_nodeNum) {}
+
+void ConflictTable::clear() {
+  cells.clear();
+  visits.clear();
+  for (auto i : touched) stays[i].clear();
+  touched.clear();
+  paths.clear();
+  maxLength = 0;
+}
+
+void ConflictTable::add(int id, const Nodes& path) {
+  if (path.empty()) return;
+  if (paths.size() <= id) paths.resize(id + 1, nullptr);
+  paths[id] = &path;
+  int last = path.size() - 1;
+  for (int t = 0; t < last; ++t) {
+    uint64_t key = (uint64_t)t * nodeNum + path[t]->getIndex();
+    auto res = cells.emplace(key, visits.size());
+    visits.push_back({ id, res.second ? -1 : res.first->second });
+    res.first->second = visits.size() - 1;
+  }
+  int i = path[last]->getIndex();
+  if (stays[i].empty()) touched.push_back(i);
+  stays[i].push_back({ last, id });
+  if (path.size() > maxLength) maxLength = path.size();
+}
+
+int ConflictTable::count(Node* u, Node* v, int t) {
+  int cnt = 0;
+  for (int k = first(t, v); k != -1; k = visits[k].next) ++cnt;
+  for (auto& x : stays[v->getIndex()]) {
+    if (x.t <= t) ++cnt;
+  }
+  // staying paths never swap
+  if (u == v) return cnt;
+  for (int k = first(t, u); k != -1; k = visits[k].next) {
+    if (at(*paths[visits[k].id], t-1) == v) ++cnt;
+  }
+  for (auto& x : stays[u->getIndex()]) {
+    if (x.t <= t && at(*paths[x.id], t-1) == v) ++cnt;
+  }
+  return cnt;
+}
+
+void ConflictTable::getColliding(const Nodes& path, std::vector<int>& ids) {
+  ids.clear();
+  if (path.empty()) return;
+  Node* u;
+  Node* v;
+  for (int t = 0; t < path.size(); ++t) {
+    v = path[t];
+    for (int k = first(t, v); k != -1; k = visits[k].next) {
+      ids.push_back(visits[k].id);
+    }
+    for (auto& x : stays[v->getIndex()]) {
+      if (x.t <= t) ids.push_back(x.id);
+    }
+    if (t == 0 || path[t-1] == v) continue;
+    u = path[t-1];
+    for (int k = first(t, u); k != -1; k = visits[k].next) {
+      if (at(*paths[visits[k].id], t-1) == v) ids.push_back(visits[k].id);
+    }
+    for (auto& x : stays[u->getIndex()]) {
+      if (x.t <= t && at(*paths[x.id], t-1) == v) ids.push_back(x.id);
+    }
+  }
+  // staying at the goal after the end
+  v = path.back();
+  for (int t = path.size(); t < maxLength; ++t) {
+    for (int k = first(t, v); k != -1; k = visits[k].next) {
+      ids.push_back(visits[k].id);
+    }
+  }
+  for (auto& x : stays[v->getIndex()]) ids.push_back(x.id);
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
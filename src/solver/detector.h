@@ -0,0 +1,119 @@
+/*
+ * detector.h
+ *
+ * Purpose: conflict detection among paths by sweeping time once
+ *
+ * At each timestep, registered paths are put into an occupancy buffer
+ * indexed by node, then vertex and swap conflicts are found by looking
+ * up the node of each path, i.e., O(paths * makespan) in total.
+ * Paths stay at their last node after the end.
+ *
+ * ConflictTable is a conflict-avoidance table for one path at a time,
+ * listing visits of other paths per (time, node), so that conflicts of a move
+ * are counted without walking the other paths.
+ */
+
+#pragma once
+
+#include "../graph/graph.h"
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+class ConflictDetector {
+public:
+  struct Collision {
+    int t;        // at timestep t
+    int i;        // id
+    int j;        // id
+    bool onNode;  // vertex or swap
+  };
+
+private:
+  struct Entry {
+    int id;
+    const Nodes* path;
+    bool fixed;  // e.g., paths of other blocks
+  };
+
+  std::vector<Entry> entries;
+  int maxLength;
+
+  // occupancy at the current timestep
+  std::vector<int> head;   // node index -> first entry at the node
+  std::vector<int> stamp;  // node index -> layer when head is valid
+  std::vector<int> next;   // entry -> next entry at the same node
+  int layer;
+
+  static Node* at(const Entry& e, int t) {
+    return (t < e.path->size()) ? (*e.path)[t] : e.path->back();
+  }
+  bool inRange(const Entry& e1, const Entry& e2, int t) {
+    return t < e1.path->size() || t < e2.path->size();
+  }
+  void build(int t, bool fixed);  // entries are listed in registered order
+  int first(Node* v);  // -1 -> empty
+
+public:
+  ConflictDetector(int nodeNum);
+  ~ConflictDetector() {};
+
+  void clear();
+  // the path must be alive until clear
+  void add(int id, const Nodes& path, bool fixed = false);
+
+  // first conflict among unfixed paths, in order of time then registration,
+  // swaps are reported with the smallest id j greater than i
+  bool findFirst(Collision& c);
+  // all conflicts among unfixed paths, in the same order,
+  // i is registered before j
+  void findAll(std::vector<Collision>& cols);
+  // pairs (i, j) of ids, i < j, of unfixed paths colliding at least once,
+  // sorted without duplicates
+  void getPairs(std::vector<std::pair<int, int>>& pairs);
+  int countPairs();
+  // number of (timestep, pair) colliding between unfixed and fixed paths
+  int countCollisions();
+};
+
+class ConflictTable {
+private:
+  struct Visit {
+    int id;
+    int next;  // next visit at the same (t, node), -1 -> none
+  };
+  struct Stay {
+    int t;  // at the last node of the path, from t on
+    int id;
+  };
+
+  int nodeNum;
+  int maxLength;
+  std::unordered_map<uint64_t, int> cells;  // (t, node index) -> first visit
+  std::vector<Visit> visits;
+  std::vector<std::vector<Stay>> stays;  // node index -> paths ending there
+  std::vector<int> touched;  // node indexes with stays, to be cleared
+  std::vector<const Nodes*> paths;  // id -> path
+
+  int first(int t, Node* v) {
+    auto itr = cells.find((uint64_t)t * nodeNum + v->getIndex());
+    return (itr == cells.end()) ? -1 : itr->second;
+  }
+  static Node* at(const Nodes& path, int t) {
+    return (t < path.size()) ? path[t] : path.back();
+  }
+
+public:
+  ConflictTable(int nodeNum);
+  ~ConflictTable() {};
+
+  void clear();
+  // the path must be alive until clear
+  void add(int id, const Nodes& path);
+
+  // number of vertex and swap conflicts of the move u -> v at t
+  int count(Node* u, Node* v, int t);
+  // ids colliding with the path at least once, sorted
+  void getColliding(const Nodes& path, std::vector<int>& ids);
+};
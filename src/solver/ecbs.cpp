@@ -10,156 +10,186 @@
  */
 
 #include "ecbs.h"
+#include <set>
 #include "../util/util.h"
 
 
-ECBS::ECBS(Problem* _P, float _w) : CBS(_P, false), w(_w) {
-  init();
-}
-ECBS::ECBS(Problem* _P, float _w, bool _ID) : CBS(_P, _ID), w(_w) {
-  init();
-}
+ECBS::ECBS(Problem* _P, float _w) : CBS(_P, false), w(_w) {}
+ECBS::ECBS(Problem* _P, float _w, bool _ID) : CBS(_P, _ID), w(_w) {}
 
 ECBS::~ECBS() {}
 
-void ECBS::init() {
-  for (auto a : A) table_fmin.emplace(a->getId(), 0);
-}
+// OPEN, ordered by lower bound
+struct OpenECTNode {
+  CTNode* node;
+  int order;
+
+  bool operator<(const OpenECTNode& other) const {
+    if (node->LB != other.node->LB) return node->LB > other.node->LB;
+    return order > other.order;
+  }
+};
+
+// FOCAL, ordered by number of conflicts, then cost
+struct FocalECTNode {
+  CTNode* node;
+  int conflict;
+  int order;
+
+  bool operator<(const FocalECTNode& other) const {
+    if (conflict != other.conflict) return conflict > other.conflict;
+    if (node->cost != other.node->cost) return node->cost > other.node->cost;
+    if (node->collisions != other.node->collisions) {
+      return node->collisions > other.node->collisions;
+    }
+    return order > other.order;
+  }
+};
 
 bool ECBS::solvePart(Paths& paths, Agents& block) {
+  using OpenHeap = boost::heap::fibonacci_heap<OpenECTNode>;
+  using FocalHeap = boost::heap::fibonacci_heap<FocalECTNode>;
+  struct Entry {
+    CTNode* node;
+    int conflict;  // h3
+    OpenHeap::handle_type handle;
+    FocalHeap::handle_type handleF;
+    bool inFocal;
+  };
+
   CTNode* node;
   Constraints constraints;
 
-  int uuid = 0;
-  int key, keyF;
-  std::unordered_set<int> OPEN;
-  std::vector<int> FOCUL;  // for FOCUL search
+  // every node in OPEN is in either FOCAL or WAIT
+  OpenHeap OPEN;
+  FocalHeap FOCAL;
+  std::set<std::pair<int, int>> WAIT;  // (cost, order), cost > ub
+  std::vector<Entry> table;  // order -> entry
   float ub;
+  int key;
 
   bool status = true;
-  bool updateMin = true;
-
-  std::vector<CTNode*> table;
-  std::vector<int> table_conflict;
-
-  CTNode* root = new CTNode { {}, {}, 0, nullptr, true, {}, 0 };
-  invoke(root, block);
-  OPEN.insert(uuid);
-  table.push_back(root);
-  table_conflict.push_back(h3(root->paths));
-  ++uuid;
 
   bool CAT = std::any_of(paths.begin(), paths.end(),
                          [](Nodes p) { return !p.empty(); });
 
-  auto itrO = OPEN.begin();
-
-  while (!OPEN.empty()) {
-
-    if (updateMin) {
-      itrO = std::min_element(OPEN.begin(), OPEN.end(),
-                              [CAT, this, &paths, &table]
-                              (int a, int b) {
-                                CTNode* nA = table[a];
-                                CTNode* nB = table[b];
-                                if (CAT && nA->cost == nB->cost) {
-                                  return this->countCollisions(nA, paths)
-                                    < this->countCollisions(nB, paths);
-                                }
-                                return nA->cost < nB->cost;
-                              });
+  auto toFocal = [&] (int k) {
+    Entry& e = table[k];
+    e.handleF = FOCAL.push({ e.node, e.conflict, k });
+    e.inFocal = true;
+  };
+  auto push = [&] (CTNode* n) {
+    int k = table.size();
+    if (CAT) n->collisions = countCollisions(n, paths);
+    table.push_back({ n, h3(n), OpenHeap::handle_type(),
+                      FocalHeap::handle_type(), false });
+    table[k].handle = OPEN.push({ n, k });
+    if ((float)n->cost <= ub) {
+      toFocal(k);
+    } else {
+      WAIT.insert({ n->cost, k });
     }
+  };
 
-    key = *itrO;
-    node = table[key];
+  CTNode* root = ctNodes.create({ {}, {}, 0, nullptr, true, {}, 0, 0 });
+  invoke(root, block);
+  ub = root->LB * w;
+  push(root);
 
-    ub = node->LB * w;
-    // update focul
-    FOCUL.clear();
-    for (auto keyO : OPEN) {
-      if ((float)table[keyO]->cost <= ub) FOCUL.push_back(keyO);
+  while (!OPEN.empty()) {
+    // lower bound rises
+    ub = OPEN.top().node->LB * w;
+    while (!WAIT.empty() && (float)WAIT.begin()->first <= ub) {
+      key = WAIT.begin()->second;
+      WAIT.erase(WAIT.begin());
+      toFocal(key);
+    }
+    // lower bound falls, removed lazily
+    while (!FOCAL.empty() && (float)FOCAL.top().node->cost > ub) {
+      key = FOCAL.top().order;
+      FOCAL.pop();
+      table[key].inFocal = false;
+      WAIT.insert({ table[key].node->cost, key });
     }
-    auto itrF = std::min_element(FOCUL.begin(), FOCUL.end(),
-                                 [&table, &table_conflict]
-                                 (int a, int b) {
-                                   int sA = table_conflict[a];
-                                   int sB = table_conflict[b];
-                                   if (sA == sB) {
-                                     return table[a]->cost < table[b]->cost;
-                                   }
-                                   return sA < sB; });
-
-    keyF = *itrF;
-    node = table[keyF];
+
+    key = FOCAL.empty() ? OPEN.top().order : FOCAL.top().order;
+    node = table[key].node;
 
     constraints = valid(node, block);
     if (constraints.empty()) break;
 
-    updateMin = (key == keyF);
-    auto itrP = std::find(OPEN.begin(), OPEN.end(), keyF);
-    OPEN.erase(itrP);
-
+    std::vector<CTNode*> children;
     for (auto constraint : constraints) {
-      CTNode* newNode = new CTNode { constraint, node->paths,
-                                     0, node, true, {}, 0 };
-      // formating
-      Node* g;
-      Nodes p;
-      for (int i = 0; i < node->paths.size(); ++i) {
-        p = newNode->paths[i];
-        if (p.empty()) continue;
-        g = *(p.end() - 1);
-        while (*(p.end() - 1) == g) p.erase(p.end() - 1);
-        p.push_back(g);
-        node->paths[i] = p;
-      }
+      CTNode* newNode = ctNodes.create({ constraint, node->paths,
+                                         0, node, true, {}, 0, 0 });
       newNode->fmins = node->fmins;
-      invoke(newNode, block);
-      if (newNode->valid) {
-        OPEN.insert(uuid);
-        table.push_back(newNode);
-        table_conflict.push_back(h3(newNode->paths));
-        ++uuid;
+      newNode->conflictPairs = node->conflictPairs;
+      children.push_back(newNode);
+    }
+
+    // planned in parallel, inserted in order
+    pool->run(children.size(), [&](int k) { invoke(children[k], block); });
+
+    // keep the node in OPEN, its cost might be decreased
+    Entry& e = table[key];
+    int cost = node->cost;
+    if (bypass && bypassChild(node, e.conflict, children)) {
+      e.conflict = h3(node);
+      if (CAT) node->collisions = countCollisions(node, paths);
+      if (e.inFocal) {
+        (*e.handleF).conflict = e.conflict;
+        FOCAL.update(e.handleF);
+      } else {
+        WAIT.erase({ cost, key });
+        WAIT.insert({ node->cost, key });
       }
+      constraints.clear();
+      continue;
+    }
+
+    OPEN.erase(e.handle);
+    if (e.inFocal) {
+      FOCAL.erase(e.handleF);
+    } else {
+      WAIT.erase({ cost, key });
+    }
+
+    for (auto newNode : children) {
+      if (newNode->valid) push(newNode);
     }
     constraints.clear();
   }
 
   if (!OPEN.empty()) {  // sucssess
     for (int i = 0; i < paths.size(); ++i) {
-      if (!node->paths[i].empty()) {
-        paths[i] = node->paths[i];
-      }
+      if (node->paths[i]) paths[i] = *node->paths[i];
     }
     status = status && true;
   } else {
     status = false;
   }
+  releaseBlock();
 
   return status;
-
 }
 
+// paths are indexed by agent id, nullptr -> no path
 void ECBS::invoke(CTNode* node, Agents& block) {
-  int d;
   // calc path
   if (node->c.empty()) {  // initail
-    Paths paths;
-    for (int i = 0; i < A.size(); ++i) {
-      paths.push_back({});
-      node->fmins.push_back(0);
+    node->paths = CTPaths(A.size(), nullptr);
+    node->fmins = std::vector<int>(A.size(), 0);
+    pool->run(block.size(), [&](int k) {
+        Agent* a = block[k];
+        node->paths[a->getId()] = makeCTPath(AstarSearch(a, node));
+      });
+    detector.clear();
+    for (int i = 0; i < node->paths.size(); ++i) {
+      if (node->paths[i]) detector.add(i, *node->paths[i]);
     }
-    for (auto a : block) {
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      int d = std::distance(A.begin(), itr);
-      paths[d] = AstarSearch(a, node);
-      node->fmins[d] = table_fmin.at(a->getId());
-    }
-    node->paths = paths;
+    detector.getPairs(node->conflictPairs);
     node->LB = 0;
   } else {
-    Agent* a;
     // error check
     if (node->paths.size() != A.size()) {
       std::cout << "error@ECBS@invoke, "
@@ -167,66 +197,23 @@ void ECBS::invoke(CTNode* node, Agents& block) {
       std::exit(1);
     }
 
+    for (auto c : node->c) node->paths[c->a->getId()] = nullptr;
     for (auto c : node->c) {
-      a = c->a;
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      if (itr == A.end()) {
-        std::cout << "error@ECBS@invoke, cannot find1 agent" << "\n";
-        std::exit(1);
-      }
-      d = std::distance(A.begin(), itr);
-      node->paths[d].clear();
-    }
-
-    for (auto c : node->c) {
-      a = c->a;
-      auto itr = std::find_if(A.begin(), A.end(),
-                              [a](Agent* b) { return a == b; });
-      if (itr == A.end()) {
-        std::cout << "error@ECBS@invoke, cannot find2 agent" << "\n";
-        std::exit(1);
-      }
-      d = std::distance(A.begin(), itr);
-      node->paths[d] = AstarSearch(a, node);
-      node->fmins[d] = table_fmin.at(a->getId());
+      node->paths[c->a->getId()] = makeCTPath(AstarSearch(c->a, node));
     }
   }
   for (auto i : node->fmins) node->LB += i;
+  // reduced here, searches run in parallel
+  for (auto a : block) {
+    if (!node->paths[a->getId()]) node->valid = false;
+  }
 
   if (!node->valid) return;
   calcCost(node, block);
-  formalizePathAgents(node, block);
 }
 
-int ECBS::h3(Agent* a, Nodes &p1, Paths &paths) {
-  if (p1.empty()) return 0;
-
-  int collision = 0;
-  Nodes p2;
-
-  for (int i = 0; i < paths.size(); ++i) {
-    if (a->getId() == i) continue;
-    p2 = paths[i];
-    if (p2.empty()) continue;
-    for (int t = 0; t < p1.size(); ++t) {
-      if (t >= p2.size()) {
-        if (p1[t] == p2[p2.size() - 1]) {
-          ++collision;
-          break;
-        }
-        continue;
-      }
-      if (p1[t] == p2[t]) {  // collision
-        ++collision;
-        break;
-      }
-      if (t > 0 && p1[t-1] == p2[t] && p1[t] == p2[t-1]) {
-        ++collision;
-        break;
-      }
-    }
-  }
+int ECBS::h3(CTNode* node) {
+  int collision = node->conflictPairs.size();
 
   // error check
   if (collision > A.size() * (A.size() - 1) / 2) {
@@ -237,85 +224,45 @@ int ECBS::h3(Agent* a, Nodes &p1, Paths &paths) {
   return collision;
 }
 
-int ECBS::h3(Paths &paths) {
-
-  int collision = 0;
-  Nodes p1, p2;
-
+// other paths of the node, for the agent
+ConflictTable& ECBS::setCAT(Agent* a, CTPaths& paths) {
+  ConflictTable& cat = getCAT();
+  cat.clear();
   for (int i = 0; i < paths.size(); ++i) {
-    for (int j = i + 1; j < paths.size(); ++j) {
-      if (paths[i].size() >= paths[j].size()) {
-        p1 = paths[i];
-        p2 = paths[j];
-      } else {
-        p1 = paths[j];
-        p2 = paths[i];
-      }
-
-      if (p2.empty()) continue;
-
-      for (int t = 0; t < p1.size(); ++t) {
-        if (t >= p2.size()) {
-          // goal pos
-          if (p1[t] == p2[p2.size() - 1]) {
-            ++collision;
-            break;
-          }
-          continue;
-        }
-        if (p1[t] == p2[t]) {  // collision
-          ++collision;
-          break;
-        }
-        // intersection
-        if (t > 0 && p1[t-1] == p2[t] && p1[t] == p2[t-1]) {
-          ++collision;
-          break;
-        }
-      }
-    }
-  }
-
-  // error check
-  if (collision > A.size() * (A.size() - 1) / 2) {
-    std::cout << "error@ECBS::h3, invalid value, " << collision << "\n";
-    std::exit(1);
+    if (i != a->getId() && paths[i]) cat.add(i, *paths[i]);
   }
-
-  return collision;
+  return cat;
 }
 
-struct Fib_FN { // Forcul Node for Fibonacci heap
-  Fib_FN(AN* _node, int _h): node(_node), h(_h) {}
-  AN* node;
-  int h;
-
-  bool operator<(const Fib_FN& other) const {
-    if (h != other.h) {
-      return h > other.h;
-    } else {
-      if (node->f != other.node->f) {
-        return node->f > other.node->f;
-      } else {
-        return node->g < other.node->g;
-      }
-    }
-  }
-};
+// replace pairs with the agent by those of the new path
+void ECBS::updateConflictPairs(CTNode* node, Agent* a, const Nodes& path,
+                               ConflictTable& cat) {
+  int id = a->getId();
+  auto& pairs = node->conflictPairs;
+  pairs.erase(std::remove_if(pairs.begin(), pairs.end(),
+                             [id] (const std::pair<int, int>& p) {
+                               return p.first == id || p.second == id; }),
+              pairs.end());
+  std::vector<int> ids;
+  cat.getColliding(path, ids);
+  for (auto j : ids) pairs.push_back(std::minmax(id, j));
+  std::sort(pairs.begin(), pairs.end());
+}
 
 Nodes ECBS::AstarSearch(Agent* a, CTNode* node) {
   Constraint constraints = getConstraintsForAgent(node, a);
+  SpaceTimeAstar& astar = getAstar();
 
   Node* _s = a->getNode();
   Node* _g = a->getGoal();
 
-  Nodes path, tmpPath, C;  // return
+  Nodes path;  // return
 
   // ==== fast implementation ====
   // constraint free
   if (constraints.empty()) {
     path = G->getPath(_s, _g);
-    table_fmin.at(a->getId()) = path.size() - 1;
+    node->fmins[a->getId()] = path.size() - 1;
     return path;
   }
 
@@ -330,172 +277,50 @@ Nodes ECBS::AstarSearch(Agent* a, CTNode* node) {
   }
   // =============================
 
-  auto paths = node->paths;
-
-  int f, g;
-  float ub;
-  int ubori;
-  std::string key, keyM, keyF;
-  bool invalid = true;
-
-  boost::heap::fibonacci_heap<Fib_AN> OPEN;
-  std::unordered_map<std::string, boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
-  std::unordered_set<std::string> CLOSE;  // key
-  AN* n = new AN { _s, 0, pathDist(_s, _g), nullptr };
-  auto handle = OPEN.push(Fib_AN(n));
-  key = getKey(n);
-  SEARCHED.emplace(key, handle);
-
-  bool updateMin = true;
-  std::unordered_map<std::string, int> table_conflict;
-  table_conflict.emplace(key, 0);
-  // FOCUL
-  boost::heap::fibonacci_heap<Fib_FN> FOCUL;
-  std::unordered_map<std::string,
-                     boost::heap::fibonacci_heap<Fib_FN>::handle_type> SEARCHED_F;
-
-  while (!OPEN.empty()) {
-    if (updateMin || FOCUL.empty()) {
-      // argmin
-      while (!OPEN.empty()
-             && CLOSE.find(getKey(OPEN.top().node)) != CLOSE.end()) OPEN.pop();
-      if (OPEN.empty()) break;
-      n = OPEN.top().node;
-      ubori = n->f;
-      keyM = getKey(n);
-      ub = n->f * w;
-      // update focul
-      FOCUL.clear();
-      SEARCHED_F.clear();
-      for (auto itr = OPEN.ordered_begin(); itr != OPEN.ordered_end(); ++itr) {
-        AN* l = (*itr).node;
-        if ((float)l->f <= ub) {
-          if (CLOSE.find(getKey(l)) == CLOSE.end()) {
-            key = getKey(l);
-            auto handle_f = FOCUL.push(Fib_FN(l, table_conflict.at(key)));
-            SEARCHED_F.emplace(key, handle_f);
-          }
-        } else {
-          break;
-        }
-      }
-    }
-
-    // argmin in FOCUL
-    n = FOCUL.top().node;
-    key = getKey(n);
-    FOCUL.pop();
-
-    // already explored
-    if (CLOSE.find(key) != CLOSE.end()) continue;
+  ConflictTable& cat = setCAT(a, node->paths);
 
+  AN* n = astar.searchFocal(
+    G, _s, 0, pathDist(_s, _g), w,
     // check goal
-    if (n->v == _g) {
-      if (!existGoalConstraint || timeGoalConstraint < n->g) {
-        invalid = false;
-        break;
-      }
-    }
-
-    // update list
-    updateMin = (key == keyM);
-    CLOSE.emplace(key);
-
-    // search neighbor
-    C = G->neighbor(n->v);
-    C.push_back(n->v);
-
-    for (auto m : C) {
-      g = n->g + 1;
-      key = getKey(g, m);
-      if (CLOSE.find(key) != CLOSE.end()) continue;
-
-      // check constraints
-      auto constraint = std::find_if(constraints.begin(), constraints.end(),
-                                     [a, g, m, n] (Conflict* c) {
-                                       if (c->a != a) return false;
-                                       if (c->t != g) return false;
-                                       if (c->onNode) return c->v == m;
-                                       return c->v == m && c->u == n->v;
-                                     });
-      if (constraint != constraints.end()) continue;
-      f = g + pathDist(m, _g);
-
-      // ==== fast implementation ====
-      // when field is huge, this works well
-      // if (existGoalConstraint) {
-      //   f = pathDist(m, _g) + timeGoalConstraint;
-      // }
-      // =============================
-
-      auto itrS = SEARCHED.find(key);
-      AN* l;
-      bool updateH = false;
-      if (itrS == SEARCHED.end()) {  // new node
-        l = new AN { m, g, f, n };
-        auto handle = OPEN.push(Fib_AN(l));
-        SEARCHED.emplace(key, handle);
-        getPartialPath(l, tmpPath);
-        table_conflict.emplace(key, h3(a, tmpPath, paths));
-      } else {
-        auto handle = itrS->second;
-        l = (*handle).node;
-        if (l->f > f) {
-          l->g = g;
-          l->f = f;
-          l->p = n;
-          getPartialPath(l, tmpPath);
-          table_conflict.at(key) = h3(a, tmpPath, paths);
-          OPEN.increase(handle);
-          updateH = true;
-        }
-      }
-
-      tmpPath.clear();
-      if (f <= ub) {
-        auto itrSF = SEARCHED_F.find(key);
-        if (itrSF == SEARCHED_F.end()) {
-          auto handle_f = FOCUL.push(Fib_FN(l, table_conflict.at(key)));
-          SEARCHED_F.emplace(key, handle_f);
-        } else {
-          if (updateH) {
-            auto handle_f = itrSF->second;
-            (*handle_f).h = table_conflict.at(key);
-            FOCUL.increase(handle_f);
-          }
-        }
-      }
-    }
-  }
+    [&] (AN* n) {
+      return n->v == _g && (!existGoalConstraint || timeGoalConstraint < n->g);
+    },
+    // check constraints
+    [&] (AN* n, Node* m, int g) {
+      return std::none_of(constraints.begin(), constraints.end(),
+                          [a, g, m, n] (Conflict* c) {
+                            if (c->a != a) return false;
+                            if (c->t != g) return false;
+                            if (c->onNode) return c->v == m;
+                            return c->v == m && c->u == n->v;
+                          });
+    },
+    [&] (AN* n, Node* m, int g) { return g + pathDist(m, _g); },
+    // number of conflicts
+    [&] (AN* n, Node* m, int g) { return cat.count(n->v, m, g); },
+    [] (AN* l) { return (float)l->f; });
 
   // back tracking
   int fmin = 0;
-  if (!invalid) {  // check failed or not
-    getPartialPath(n, path);
-    fmin = ubori;
-  } else {
-    node->valid = false;
+  if (n != nullptr) {  // empty path -> failed
+    path = SpaceTimeAstar::getPath(n);
+    fmin = astar.getFmin();
   }
-  table_fmin.at(a->getId()) = fmin;
+  node->fmins[a->getId()] = fmin;
+  updateConflictPairs(node, a, path, cat);
 
   return path;
 }
 
-void ECBS::getPartialPath(AN* n, Nodes &path) {
-  path.clear();
-  AN* m = n;
-  while (m != nullptr) {
-    path.push_back(m->v);
-    m = m->p;
-  }
-  std::reverse(path.begin(), path.end());
-}
-
 std::string ECBS::logStr() {
   std::string str;
   str += "[solver] type:ECBS\n";
   str += "[solver] w:" + std::to_string(w) + "\n";
   str += "[solver] ID:" + std::to_string(ID) + "\n";
+  str += "[solver] threads:" + std::to_string(pool->size()) + "\n";
+  str += "[solver] bypass:" + std::to_string(bypass) + "\n";
+  str += "[solver] bypass_cnt:" + std::to_string(bypassCnt) + "\n";
+  str += arenaLogStr();
   str += Solver::logStr();
   return str;
 }
@@ -12,15 +12,15 @@
 class ECBS : public CBS {
 protected:
   float w;  // sub-optimal factor
-  std::unordered_map<int, int> table_fmin;  // record min of f-value
-
-  virtual void init();
-  int h3(Paths &paths);
-  int h3(Agent* a, Nodes& p1, Paths &paths);
+  int h3(CTNode* node);
   bool solvePart(Paths& paths, Agents& block);
   void invoke(CTNode* node, Agents& block);
   virtual Nodes AstarSearch(Agent* a, CTNode* node);
-  void getPartialPath(AN* n, Nodes &path);
+
+  // conflicts are updated per replanned agent, not recounted
+  ConflictTable& setCAT(Agent* a, CTPaths& paths);
+  void updateConflictPairs(CTNode* node, Agent* a, const Nodes& path,
+                           ConflictTable& cat);
 
 public:
   ECBS(Problem* _P, float _w);
@@ -113,41 +113,20 @@ void iECBS::init() {
   }
 }
 
-struct Fib_FN_iECBS { // Forcul Node for Fibonacci heap, iECBS
-  Fib_FN_iECBS(AN* _node, int _h, float _highway)
-    : node(_node), h(_h), highway(_highway) {}
-  AN* node;
-  int h;
-  float highway;
-
-  bool operator<(const Fib_FN_iECBS & other) const {
-    if (h != other.h) {
-      return h > other.h;
-    } else {  // h == other.h
-      float cThis  = highway + (float)node->g;
-      float cOther = other.highway + (float)other.node->g;
-      if (cThis != cOther) {
-        return cThis > cOther;
-      } else {
-        return node->g < other.node->g;
-      }
-    }
-  }
-};
-
 Nodes iECBS::AstarSearch(Agent* a, CTNode* node) {
   Constraint constraints = getConstraintsForAgent(node, a);
+  SpaceTimeAstar& astar = getAstar();
 
   Node* _s = a->getNode();
   Node* _g = a->getGoal();
 
-  Nodes path, tmpPath, C;
+  Nodes path;
 
   // ==== fast implementation ====
   // constraint free
   if (constraints.empty()) {
     path = G->getPath(_s, _g);
-    table_fmin.at(a->getId()) = path.size() - 1;
+    node->fmins[a->getId()] = path.size() - 1;
     return path;
   }
 
@@ -162,154 +141,43 @@ Nodes iECBS::AstarSearch(Agent* a, CTNode* node) {
   }
   // =============================
 
-  auto paths = node->paths;
-
-  int f, g;
-  float ub;
-  int ubori;
-  std::string key, keyF, keyM;
-  bool invalid = true;
-
-  boost::heap::fibonacci_heap<Fib_AN> OPEN;
-  std::unordered_map<std::string, boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
-  std::unordered_set<std::string> CLOSE;  // key
-  AN* n = new AN { _s, 0, pathDist(_s, _g), nullptr };
-  auto handle = OPEN.push(Fib_AN(n));
-  key = getKey(n);
-  SEARCHED.emplace(key, handle);
-
-  bool updateMin = true;
-  std::unordered_map<std::string, int> table_conflict;
-  table_conflict.emplace(key, 0);
-  // FOCUL
-  boost::heap::fibonacci_heap<Fib_FN_iECBS> FOCUL;
-  std::unordered_map<std::string,
-                     boost::heap::fibonacci_heap<Fib_FN_iECBS>::handle_type> SEARCHED_F;
-
-  while (!OPEN.empty()) {
-    // argmin
-    if (updateMin || FOCUL.empty()) {
-      // argmin
-      while (!OPEN.empty()
-             && CLOSE.find(getKey(OPEN.top().node)) != CLOSE.end()) OPEN.pop();
-      if (OPEN.empty()) break;
-      n = OPEN.top().node;
-      ubori = n->f;
-      keyM = getKey(n);
-      ub = n->f * w;
-      // update focul
-      FOCUL.clear();
-      SEARCHED_F.clear();
-      for (auto itr = OPEN.ordered_begin(); itr != OPEN.ordered_end(); ++itr) {
-        AN* l = (*itr).node;
-        if (CLOSE.find(getKey(l)) == CLOSE.end()) {
-          key = getKey(l);
-          auto handle_f = FOCUL.push(Fib_FN_iECBS(l, table_conflict.at(key),
-                                                  highwayCost(l->v, _g)));
-          SEARCHED_F.emplace(key, handle_f);
-        } else {
-          break;
-        }
-      }
-    }
-
-    // argmin in FOCUL
-    n = FOCUL.top().node;
-    key = getKey(n);
-    FOCUL.pop();
-
-    // already explored
-    if (CLOSE.find(key) != CLOSE.end()) continue;
+  ConflictTable& cat = setCAT(a, node->paths);
 
+  AN* n = astar.searchFocal(
+    G, _s, 0, pathDist(_s, _g), w,
     // check goal
-    if (n->v == _g) {
-      if (!existGoalConstraint || timeGoalConstraint < n->g) {
-        invalid = false;
-        break;
-      }
-    }
-
-    // update list
-    updateMin = (key == keyM);
-    CLOSE.emplace(key);
-
-    // search neighbor
-    C = G->neighbor(n->v);
-    C.push_back(n->v);
-
-    for (auto m : C) {
-      g = n->g + 1;
-      key = getKey(g, m);
-      if (CLOSE.find(key) != CLOSE.end()) continue;
-
-      // check constraints
-      auto constraint = std::find_if(constraints.begin(), constraints.end(),
-                                     [a, g, m, n] (Conflict* c) {
-                                       if (c->a != a) return false;
-                                       if (c->t != g) return false;
-                                       if (c->onNode) return c->v == m;
-                                       return c->v == m && c->u == n->v;
-                                     });
-      if (constraint != constraints.end()) continue;
-      f = g + pathDist(m, _g);
-
+    [&] (AN* n) {
+      return n->v == _g && (!existGoalConstraint || timeGoalConstraint < n->g);
+    },
+    // check constraints
+    [&] (AN* n, Node* m, int g) {
+      return std::none_of(constraints.begin(), constraints.end(),
+                          [a, g, m, n] (Conflict* c) {
+                            if (c->a != a) return false;
+                            if (c->t != g) return false;
+                            if (c->onNode) return c->v == m;
+                            return c->v == m && c->u == n->v;
+                          });
+    },
+    [&] (AN* n, Node* m, int g) {
       // ==== fast implementation ====
-      if (existGoalConstraint) {
-        f = pathDist(m, _g) + timeGoalConstraint;
-      }
+      if (existGoalConstraint) return pathDist(m, _g) + timeGoalConstraint;
       // =============================
-
-      auto itrS = SEARCHED.find(key);
-      AN* l;
-      bool updateH = false;
-      if (itrS == SEARCHED.end()) {  // new node
-        l = new AN { m, g, f, n };
-        auto handle = OPEN.push(Fib_AN(l));
-        SEARCHED.emplace(key, handle);
-        getPartialPath(l, tmpPath);
-        table_conflict.emplace(key, h3(a, tmpPath, paths));
-      } else {
-        auto handle = itrS->second;
-        l = (*handle).node;
-        if (l->f > f) {
-          l->g = g;
-          l->f = f;
-          l->p = n;
-          getPartialPath(l, tmpPath);
-          table_conflict.at(key) = h3(a, tmpPath, paths);
-          OPEN.increase(handle);
-          updateH = true;
-        }
-      }
-
-      tmpPath.clear();
-      if (f <= ub) {
-        auto itrSF = SEARCHED_F.find(key);
-        if (itrSF == SEARCHED_F.end()) {
-          auto handle_f = FOCUL.push(Fib_FN_iECBS(l, table_conflict.at(key),
-                                                  highwayCost(m, _g)));
-          SEARCHED_F.emplace(key, handle_f);
-        } else {
-          if (updateH) {
-            auto handle_f = itrSF->second;
-            (*handle_f).h = table_conflict.at(key);
-            FOCUL.increase(handle_f);
-          }
-        }
-      }
-    }
-
-  }
+      return g + pathDist(m, _g);
+    },
+    // number of conflicts
+    [&] (AN* n, Node* m, int g) { return cat.count(n->v, m, g); },
+    // prefer highways
+    [&] (AN* l) { return highwayCost(l->v, _g) + (float)l->g; });
 
   // back tracking
   int fmin = 0;
-  if (!invalid) {  // check failed or not
-    getPartialPath(n, path);
-    fmin = ubori;
-  } else {
-    node->valid = false;
+  if (n != nullptr) {  // empty path -> failed
+    path = SpaceTimeAstar::getPath(n);
+    fmin = astar.getFmin();
   }
-  table_fmin.at(a->getId()) = fmin;
+  node->fmins[a->getId()] = fmin;
+  updateConflictPairs(node, a, path, cat);
 
   return path;
 }
@@ -351,7 +219,8 @@ float iECBS::highwayCost(Node* _s, Node* _g) {
   boost::heap::fibonacci_heap<Fib_ANF> OPEN;
   std::unordered_map<int, boost::heap::fibonacci_heap<Fib_ANF>::handle_type> SEARCHED;
   std::unordered_set<int> CLOSE;
-  ANF* n = new ANF { _s, 0, static_cast<float>(pathDist(_s, _g)), nullptr };
+  Arena<ANF> nodes;  // released at return
+  ANF* n = nodes.create({ _s, 0, static_cast<float>(pathDist(_s, _g)), nullptr });
   auto handle = OPEN.push(Fib_ANF(n));
   SEARCHED.emplace(n->v->getId(), handle);
 
@@ -401,7 +270,7 @@ float iECBS::highwayCost(Node* _s, Node* _g) {
 
       auto itrS = SEARCHED.find(m->getId());
       if (itrS == SEARCHED.end()) {  // new node
-        ANF* l = new ANF { m, n->g + w, f, n };
+        ANF* l = nodes.create({ m, n->g + w, f, n });
         auto handle = OPEN.push(Fib_ANF(l));
         SEARCHED.emplace(l->v->getId(), handle);
       } else {
@@ -439,6 +308,7 @@ std::string iECBS::logStr() {
   str += "[solver] w:" + std::to_string(w) + "\n";
   str += "[solver] highway:" + highwayFile + "\n";
   str += "[solver] ID:" + std::to_string(ID) + "\n";
+  str += arenaLogStr();
   str += Solver::logStr();
   return str;
 }
@@ -13,6 +13,8 @@
 
 #include "pibt.h"
 #include <algorithm>
+#include <chrono>
+#include <numeric>
 #include <random>
 #include "../util/util.h"
 
@@ -39,6 +41,50 @@ void PIBT::init() {
     eta.push_back(0);
     priority.push_back(epsilon[i] + eta[i]);
   }
+
+  // initialize reservation table
+  stepCnt = 0;
+  int nodeNum = G->getNodesNum();
+  reserved = std::vector<int>(nodeNum, -1);
+  occupied = std::vector<int>(nodeNum, -1);
+  decided = std::vector<int>(agentNum, -1);
+  for (int i = 0; i < agentNum; ++i) {
+    occupied[A[i]->getNode()->getIndex()] = i;
+  }
+  observed = std::vector<int>(nodeNum, -1);
+  observeCnt = 0;
+  pending = false;
+
+  // deadline mode is disabled by default
+  deadline = 0;
+  deadlineMissCnt = 0;
+  deadlineOverrunMax = 0;
+  deadlineOverrunSum = 0;
+  degradedCnt = 0;
+  timeout = false;
+  fieldCost = 0;
+  fieldStep = -1;
+
+  densityMode = false;
+  grid = nullptr;
+}
+
+void PIBT::setDensityMode(bool flg) {
+  densityMode = flg;
+  if (!densityMode || !cells.empty()) return;
+
+  grid = dynamic_cast<Grid*>(G);
+  if (grid == nullptr) return;
+
+  // grid occupancy is read through occupied[], which moveAgent maintains
+  int w = grid->getW();
+  cells = std::vector<int>(w * grid->getH(), -1);
+  degrees = std::vector<int>(G->getNodesNum(), 0);
+  for (auto v : G->getNodes()) {
+    Vec2f pos = v->getPos();
+    cells[(int)pos.y * w + (int)pos.x] = v->getIndex();
+    degrees[v->getIndex()] = G->neighbor(v).size();
+  }
 }
 
 
@@ -56,49 +102,201 @@ bool PIBT::solve() {
   return true;
 }
 
-void PIBT::allocate() {
-  if (P->allocated()) return;
-  auto T = P->getT();
-  Graph* _G = G;
+Nodes PIBT::step() {
+  flush();
+  allocate();
+  update();
+  pending = true;
 
-  for (auto a : A) {
-    if (a->hasTask()) continue;
-    if (T.empty()) {
-      a->releaseGoalOnly();
-    } else {
-      auto v = a->getNode();
-      auto itr = std::min_element(T.begin(), T.end(),
-                                  [v, _G] (Task* t1, Task* t2) {
-                                    return _G->dist(t1->getG()[0], v)
-                                      < _G->dist(t2->getG()[0], v);
-                                  });
-      a->setGoal((*itr)->getG()[0]);
+  Nodes next(A.size());
+  for (int i = 0; i < A.size(); ++i) next[i] = A[i]->getNode();
+  return next;
+}
+
+bool PIBT::step(const Nodes& observations, Nodes& next) {
+  if (observations.size() != A.size()) {
+    std::cout << "error@PIBT::step, size of observations is "
+              << observations.size() << ", should be " << A.size() << "\n";
+    return false;
+  }
+
+  // validate all before changing anything
+  int nodeNum = G->getNodesNum();
+  int k;
+  ++observeCnt;
+  for (int i = 0; i < A.size(); ++i) {
+    Node* v = observations[i];
+    k = (v == nullptr) ? -1 : v->getIndex();
+    if (k < 0 || k >= nodeNum || G->getNodeFromIndex(k) != v) {
+      std::cout << "error@PIBT::step, invalid observation of agent "
+                << A[i]->getId() << "\n";
+      return false;
+    }
+    if (observed[k] == observeCnt) {
+      std::cout << "error@PIBT::step, node " << v->getId()
+                << " is observed twice" << "\n";
+      return false;
     }
+    observed[k] = observeCnt;
+  }
+
+  // correct locations, e.g., a robot failed to move or was re-localized
+  for (int i = 0; i < A.size(); ++i) {
+    Node* u = A[i]->getNode();
+    if (observations[i] == u) continue;
+    if (occupied[u->getIndex()] == i) occupied[u->getIndex()] = -1;
+    A[i]->relocate(observations[i]);
+    occupied[observations[i]->getIndex()] = i;
+  }
+
+  next = step();
+  return true;
+}
+
+void PIBT::flush() {
+  if (!pending) return;
+  P->update();
+  pending = false;
+}
+
+void PIBT::addAgent(Agent* a) {
+  flush();
+  if (occupied[a->getNode()->getIndex()] != -1) {
+    std::cout << "error@PIBT::addAgent, node "
+              << a->getNode()->getId() << " is occupied" << "\n";
+    std::exit(1);
   }
+
+  P->addAgent(a);
+  A.push_back(a);
+  std::uniform_real_distribution<float> dist(0, 1);
+  epsilon.push_back(dist(*MT));
+  eta.push_back(0);
+  priority.push_back(epsilon[epsilon.size() - 1]);
+  decided.push_back(-1);
+  occupied[a->getNode()->getIndex()] = A.size() - 1;
+}
+
+void PIBT::removeAgent(Agent* a) {
+  flush();
+  int i = occupied[a->getNode()->getIndex()];
+  if (i == -1 || A[i] != a) {
+    std::cout << "error@PIBT::removeAgent, agent "
+              << a->getId() << " does not exist" << "\n";
+    std::exit(1);
+  }
+
+  P->removeAgent(a);
+  occupied[a->getNode()->getIndex()] = -1;
+
+  // the last agent takes the place, same as Problem
+  int last = A.size() - 1;
+  if (i != last) {
+    A[i] = A[last];
+    epsilon[i] = epsilon[last];
+    eta[i] = eta[last];
+    priority[i] = priority[last];
+    decided[i] = decided[last];
+    occupied[A[i]->getNode()->getIndex()] = i;
+  }
+  A.pop_back();
+  epsilon.pop_back();
+  eta.pop_back();
+  priority.pop_back();
+  decided.pop_back();
 }
 
 void PIBT::update() {
-  updatePriority();
+  stepStart = std::chrono::steady_clock::now();
+  timeout = false;
 
-  std::vector<float> PL(priority.size());  // priority list
-  std::copy(priority.begin(), priority.end(), PL.begin());
+  evictGoalFields();
+  updatePriority();
+  ++stepCnt;  // reset reservation
 
-  Nodes CLOSE_NODE;
-  Agents OPEN_AGENT(A.size());
-  std::copy(A.begin(), A.end(), OPEN_AGENT.begin());
+  // sort agents by priority, stable for tie-break by index
+  std::vector<int> U(A.size());
+  std::iota(U.begin(), U.end(), 0);
+  std::stable_sort(U.begin(), U.end(),
+                   [this] (int i, int j)
+                   { return this->priority[i] > this->priority[j]; });
 
   // choose one agent with the highest priority
-  auto itr = std::max_element(PL.begin(), PL.end());
-  int index = std::distance(PL.begin(), itr);
-  Agent* a = OPEN_AGENT[index];
+  for (auto i : U) {
+    if (isDecided(i)) continue;
+    if (overBudget() || !prepareField(A[i])) {
+      moveGreedy(i);
+    } else {
+      priorityInheritance(i);
+    }
+  }
+
+  // record how far the deadline was missed
+  if (deadline > 0) {
+    float elapsed = stepElapsed();
+    if (elapsed > deadline) {
+      ++deadlineMissCnt;
+      deadlineOverrunSum += elapsed - deadline;
+      deadlineOverrunMax = std::max(deadlineOverrunMax, elapsed - deadline);
+    }
+  }
+}
+
+float PIBT::stepElapsed() {
+  return std::chrono::duration<float, std::milli>
+    (std::chrono::steady_clock::now() - stepStart).count();
+}
+
+// checked before each inheritance tree and each choice inside it,
+// the result is latched until the next step
+bool PIBT::overBudget() {
+  if (deadline <= 0 || timeout) return timeout;
+  timeout = stepElapsed() > deadline;
+  return timeout;
+}
 
-  while (!OPEN_AGENT.empty()) {
-    priorityInheritance(a, CLOSE_NODE, OPEN_AGENT, PL);
+// the BFS of a missing distance field cannot be interrupted,
+// build it only when the rest of the budget covers the last one,
+// one field per step is always allowed so that every agent gets its own
+bool PIBT::prepareField(Agent* a) {
+  if (deadline <= 0 || !a->hasGoal()) return true;
+  if (findGoalField(a->getGoal()) != nullptr) return true;
+  if (overBudget()) return false;
+  if (fieldStep == stepCnt && deadline - stepElapsed() < fieldCost) return false;
+  auto t = std::chrono::steady_clock::now();
+  goalField(a->getGoal());
+  fieldCost = std::chrono::duration<float, std::milli>
+    (std::chrono::steady_clock::now() - t).count();
+  fieldStep = stepCnt;
+  return true;
+}
 
-    itr = std::max_element(PL.begin(), PL.end());
-    index = std::distance(PL.begin(), itr);
-    a = OPEN_AGENT[index];
+// fallback after the deadline, stay or move greedily without inheritance
+// undecided agents are never on reserved nodes, hence always collision-free
+// distance fields are not built here, agents without one just stay
+void PIBT::moveGreedy(int i) {
+  Agent* a = A[i];
+  decided[i] = stepCnt;
+  ++degradedCnt;
+
+  Node* target = a->getNode();
+  const std::vector<int>* field = nullptr;
+  if (a->hasGoal()) field = findGoalField(a->getGoal());
+  if (field != nullptr) {
+    int d = (*field)[target->getIndex()];
+    int dv;
+    for (auto v : G->neighbor(a->getNode())) {
+      if (isReserved(v) || occupied[v->getIndex()] != -1) continue;
+      dv = (*field)[v->getIndex()];
+      if (dv < d) {
+        d = dv;
+        target = v;
+      }
+    }
   }
+
+  reserve(target);
+  moveAgent(i, target);
 }
 
 void PIBT::updatePriority() {
@@ -112,8 +310,11 @@ void PIBT::updatePriority() {
     } else {
       eta[i] = 0;
     }
-    priority[i] = eta[i] + epsilon[i];
-    // priority[i] = getDensity(A[i]);
+    if (densityMode) {
+      priority[i] = (grid == nullptr) ? getDensity(A[i]) : getDensity(i);
+    } else {
+      priority[i] = eta[i] + epsilon[i];
+    }
   }
 }
 
@@ -146,95 +347,129 @@ float PIBT::getDensity(Agent* a) {
   return density;
 }
 
-bool PIBT::priorityInheritance(Agent* a,
-                               Nodes& CLOSE_NODE,
-                               Agents& OPEN_AGENT,
-                               std::vector<float>& PL) {
-  Nodes C = createCandidates(a, CLOSE_NODE);
-  return priorityInheritance(a, C, CLOSE_NODE, OPEN_AGENT, PL);
+// scan the Manhattan diamond of radius 2 around A[i]
+// each neighbor u at distance d contributes (2 - d + deg(u) + [d == 1]) / deg(u)
+float PIBT::getDensity(int i) {
+  Vec2f pos = A[i]->getNode()->getPos();
+  int x = (int)pos.x;
+  int y = (int)pos.y;
+  int w = grid->getW();
+  int h = grid->getH();
+  float density = 0;
+  int d, dx, dy, k, j, deg;
+
+  for (dy = -2; dy <= 2; ++dy) {
+    if (y + dy < 0 || y + dy >= h) continue;
+    for (dx = -2; dx <= 2; ++dx) {
+      d = std::abs(dx) + std::abs(dy);
+      if (d == 0 || d > 2 || x + dx < 0 || x + dx >= w) continue;
+      k = cells[(y + dy) * w + (x + dx)];
+      if (k == -1) continue;
+      j = occupied[k];
+      if (j == -1) continue;
+      deg = degrees[k];
+      density += (float)(2 - d + deg + (d == 1 ? 1 : 0)) / (float)deg;
+    }
+  }
+
+  density /= (float)degrees[A[i]->getNode()->getIndex()];
+  return density;
+}
+
+bool PIBT::priorityInheritance(int i) {
+  Nodes C = createCandidates(A[i]);
+  return priorityInheritance(i, C);
 }
 
-bool PIBT::priorityInheritance(Agent* a,
-                               Agent* aFrom,
-                               Nodes& CLOSE_NODE,
-                               Agents& OPEN_AGENT,
-                               std::vector<float>& PL) {
-  Nodes C = createCandidates(a, CLOSE_NODE, aFrom->getNode());
-  return priorityInheritance(a, C, CLOSE_NODE, OPEN_AGENT, PL);
+bool PIBT::priorityInheritance(int i, int iFrom) {
+  Nodes C = createCandidates(A[i], A[iFrom]->getNode());
+  return priorityInheritance(i, C);
 }
 
-bool PIBT::priorityInheritance(Agent* a,
-                               Nodes C,
-                               Nodes& CLOSE_NODE,
-                               Agents& OPEN_AGENT,
-                               std::vector<float>& PL)
+bool PIBT::priorityInheritance(int i, Nodes C)
 {
-  // remove agent from OPEN_AGENT, Priority List
-  auto itr = std::find(OPEN_AGENT.begin(), OPEN_AGENT.end(), a);
-  PL.erase(PL.begin() + std::distance(OPEN_AGENT.begin(), itr));
-  OPEN_AGENT.erase(itr);
+  Agent* a = A[i];
+  decided[i] = stepCnt;
 
   Node* target;
+  int j;
 
   // main loop
   while (!C.empty()) {
 
+    // out of time or no field affordable, stay in place
+    // once out of time, the agents up the tree then stay as well
+    if (overBudget() || !prepareField(a)) {
+      ++degradedCnt;
+      reserve(a->getNode());
+      moveAgent(i, a->getNode());
+      return false;
+    }
+
     // choose target
     target = chooseNode(a, C);
-    CLOSE_NODE.push_back(target);
-
-    bool isAgent = false;
-    for (auto b : OPEN_AGENT) {
-      if (target == b->getNode()) {  // If there is an agent
-        if (priorityInheritance(b, a, CLOSE_NODE, OPEN_AGENT, PL)) {
-          // priority inheritance success
-          a->setNode(target);
-          return true;
-        } else {
-          // priority inheritance fail
-          updateC(C, target, CLOSE_NODE);
-          isAgent = true;
-          break;
-        }
-      }
-    }
+    reserve(target);
 
     // If there is an agent
-    if (!isAgent) {
-      a->setNode(target);
-      return true;
+    j = occupied[target->getIndex()];
+    if (j != -1 && !isDecided(j)) {
+      if (priorityInheritance(j, i)) {
+        // priority inheritance success
+        moveAgent(i, target);
+        return true;
+      } else {
+        // priority inheritance fail
+        updateC(C);
+        continue;
+      }
     }
+
+    moveAgent(i, target);
+    return true;
   }
 
   // failed
-  a->setNode(a->getNode());
+  moveAgent(i, a->getNode());
   return false;
 }
 
-Nodes PIBT::createCandidates(Agent* a, Nodes CLOSE_NODE) {
+Nodes PIBT::createCandidates(Agent* a) {
   Nodes C;
   for (auto v : G->neighbor(a->getNode())) {
-    if (!inArray(v, CLOSE_NODE)) C.push_back(v);
+    if (!isReserved(v)) C.push_back(v);
   }
-  if (!inArray(a->getNode(), CLOSE_NODE)) C.push_back(a->getNode());
+  if (!isReserved(a->getNode())) C.push_back(a->getNode());
   return C;
 }
 
-Nodes PIBT::createCandidates(Agent* a, Nodes CLOSE_NODE, Node* tmp) {
-  CLOSE_NODE.push_back(tmp);
-  Nodes C = createCandidates(a, CLOSE_NODE);
-  CLOSE_NODE.erase(CLOSE_NODE.end() - 1);
+Nodes PIBT::createCandidates(Agent* a, Node* tmp) {
+  Nodes C;
+  for (auto v : G->neighbor(a->getNode())) {
+    if (v != tmp && !isReserved(v)) C.push_back(v);
+  }
+  if (!isReserved(a->getNode())) C.push_back(a->getNode());
   return C;
 }
 
+void PIBT::moveAgent(int i, Node* v) {
+  Node* u = A[i]->getNode();
+  if (occupied[u->getIndex()] == i) occupied[u->getIndex()] = -1;
+  A[i]->setNode(v);
+  occupied[v->getIndex()] = i;
+}
+
 Node* PIBT::chooseNode(Agent* a, Nodes C) {
+  return chooseNode(a, C, MT);
+}
+
+Node* PIBT::chooseNode(Agent* a, Nodes C, std::mt19937* rng) {
   if (C.empty()) {
     std::cout << "error@PIBT::chooseNode, C is empty" << "\n";
     std::exit(1);
   }
 
   // randomize
-  std::shuffle(C.begin(), C.end(), *MT);
+  std::shuffle(C.begin(), C.end(), *rng);
 
   if (!a->hasGoal()) {
     if (inArray(a->getNode(), C)) {  // try to stay
@@ -244,50 +479,43 @@ Node* PIBT::chooseNode(Agent* a, Nodes C) {
     }
   }
 
-  Nodes cs;
-  int minCost = 10000;
-  int cost;
-  Node* g = a->getGoal();
-
-  // fast implementation
-  Nodes p = G->getPath(a->getNode(), g);
-  if (p.size() > 1 && inArray(p[1], C)) return p[1];
-
-  for (auto v : C) {
-    cost = pathDist(v, g);
-    if (cost < minCost) {
-      minCost = cost;
-      cs.clear();
-      cs.push_back(v);
-    } else if (cost == minCost) {
-      cs.push_back(v);
-    }
+  // rank by (distance, occupied), first one in the shuffled order wins
+  // unlike the former getPath successor, a free node is preferred on ties
+  const std::vector<int>& field = goalField(a->getGoal());
+  Node* target = C[0];
+  int minKey = (field[C[0]->getIndex()] << 1)
+    | (occupied[C[0]->getIndex()] != -1);
+  int key, k;
+  bool better;
+  for (int l = 1; l < C.size(); ++l) {
+    k = C[l]->getIndex();
+    key = (field[k] << 1) | (occupied[k] != -1);
+    better = key < minKey;  // branch-free select
+    minKey = better ? key : minKey;
+    target = better ? C[l] : target;
   }
 
-  if (cs.size() == 1) return cs[0];
-
-  // tie break
-  bool contained;
-  for (auto v : cs) {  // avoid tabu list
-    contained = std::any_of(A.begin(), A.end(),
-                            [v](Agent* b){ return b->getNode() == v; });
-    if (!contained) return v;
-  }
-
-  return cs[0];
+  return target;
 }
 
-void PIBT::updateC(Nodes& C, Node* target, Nodes CLOSE_NODE) {
-  for (auto v : CLOSE_NODE) {
-    auto itr2 = std::find_if(C.begin(), C.end(),
-                             [v] (Node* u) { return v == u; });
-    if (itr2 != C.end()) C.erase(itr2);
-  }
+void PIBT::updateC(Nodes& C) {
+  auto itr = std::remove_if(C.begin(), C.end(),
+                            [this] (Node* v) { return this->isReserved(v); });
+  C.erase(itr, C.end());
 }
 
 std::string PIBT::logStr() {
   std::string str;
   str += "[solver] type:PIBT\n";
+  if (deadline > 0) {
+    str += "[solver] deadline:" + std::to_string(deadline) + "\n";
+    str += "[solver] deadline_miss:" + std::to_string(deadlineMissCnt) + "\n";
+    str += "[solver] deadline_overrun_max:"
+      + std::to_string(deadlineOverrunMax) + "\n";
+    str += "[solver] deadline_overrun_sum:"
+      + std::to_string(deadlineOverrunSum) + "\n";
+    str += "[solver] deadline_degraded:" + std::to_string(degradedCnt) + "\n";
+  }
   str += Solver::logStr();
   return str;
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "solver.h"
+#include "../graph/grid.h"
+#include <chrono>
 
 
 
@@ -10,30 +12,55 @@ protected:
   std::vector<int> eta;  // usually increment every step
   std::vector<float> priority;  // eta + epsilon
 
+  // reservation table, indexed by node index
+  int stepCnt;                  // stamp of the current step
+  std::vector<int> reserved;    // reserved[v] == stepCnt -> v is claimed
+  std::vector<int> occupied;    // index of agent at v, -1 -> empty
+  std::vector<int> decided;     // decided[i] == stepCnt -> A[i] is done
+  std::vector<int> observed;    // observed[v] == observeCnt -> v is taken
+  int observeCnt;
+  bool pending;                 // P->update of the last step is deferred
+
+  // deadline mode
+  float deadline;            // time budget of one step [ms], 0 -> none
+  int deadlineMissCnt;       // number of steps over the budget
+  float deadlineOverrunMax;  // [ms]
+  float deadlineOverrunSum;  // [ms]
+  int degradedCnt;           // agents decided by the fallback
+  std::chrono::steady_clock::time_point stepStart;
+  bool timeout;              // the budget of the current step ran out
+  float fieldCost;           // time of the last distance field built [ms]
+  int fieldStep;             // stamp of the step building the last field
+  float stepElapsed();       // [ms]
+  bool overBudget();
+  bool prepareField(Agent* a);
+
+  // density-based prioritization
+  bool densityMode;
+  Grid* grid;                // nullptr -> not a grid, use getDensity(Agent*)
+  std::vector<int> cells;    // cell y*w+x -> node index, -1 -> obstacle
+  std::vector<int> degrees;  // node index -> number of neighbors
+
   void init();
-  void allocate();
 
   virtual void updatePriority();
-  Nodes createCandidates(Agent* a, Nodes CLOSE_NODE);
-  Nodes createCandidates(Agent* a, Nodes CLOSE_NODE, Node* tmp);
-  bool priorityInheritance(Agent* a,
-                           Nodes& CLOSE_NODE,
-                           Agents& OPEN_AGENT,
-                           std::vector<float>& PL);
-  bool priorityInheritance(Agent* a,
-                           Agent* aFrom,
-                           Nodes& CLOSE_NODE,
-                           Agents& OPEN_AGENT,
-                           std::vector<float>& PL);
-  virtual bool priorityInheritance(Agent* a,
-                                   Nodes C,
-                                   Nodes& CLOSE_NODE,
-                                   Agents& OPEN_AGENT,
-                                   std::vector<float>& PL);
+  Nodes createCandidates(Agent* a);
+  Nodes createCandidates(Agent* a, Node* tmp);
+  bool priorityInheritance(int i);
+  bool priorityInheritance(int i, int iFrom);
+  virtual bool priorityInheritance(int i, Nodes C);
   virtual Node* chooseNode(Agent* a, Nodes C);
-  void updateC(Nodes& C, Node* target, Nodes CLOSE_NODE);
+  Node* chooseNode(Agent* a, Nodes C, std::mt19937* rng);
+  void updateC(Nodes& C);
+  void moveAgent(int i, Node* v);
+  void moveGreedy(int i);
+
+  bool isReserved(Node* v) { return reserved[v->getIndex()] == stepCnt; }
+  void reserve(Node* v) { reserved[v->getIndex()] = stepCnt; }
+  bool isDecided(int i) { return decided[i] == stepCnt; }
 
   float getDensity(Agent* a);  // density can be used as effective prioritization
+  float getDensity(int i);     // same value, O(1) via cell lookup on grids
 
 public:
   PIBT(Problem* _P);
@@ -43,5 +70,20 @@ public:
   bool solve();
   virtual void update();
 
+  void setDeadline(float _deadline) { deadline = _deadline; }
+  void setDensityMode(bool flg);
+
+  // streaming use, one call per control tick
+  // returned nodes are aligned with P->getA(), the problem (history, tasks)
+  // is updated at the next call, after observed locations are applied
+  Nodes step();
+  // false -> invalid observations, e.g., duplicated nodes, nothing changes
+  bool step(const Nodes& observations, Nodes& next);
+  // apply the deferred update now, e.g., before reading P
+  void flush();
+  // both flush first, so the last move of every agent is recorded
+  void addAgent(Agent* a);
+  void removeAgent(Agent* a);
+
   virtual std::string logStr();
 };
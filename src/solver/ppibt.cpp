@@ -0,0 +1,296 @@
+/*
+ * ppibt.cpp
+ *
+ * Purpose: PIBT with inheritance trees planned in parallel
+ *
+ * One tree is planned by one worker as in PIBT. Trees run optimistically,
+ * a tree meeting a claim of a lower tree takes it over and the lower tree
+ * is rolled back. Once a round ends, the claims of rolled back trees are
+ * released and their agents become roots of the next round. The top tree
+ * of each round is never rolled back, hence rounds end up settled.
+ */
+
+
+#include "ppibt.h"
+#include <algorithm>
+#include <numeric>
+#include "../util/util.h"
+
+
+pPIBT::pPIBT(Problem* _P) : PIBT(_P)
+{
+  init();
+}
+
+pPIBT::pPIBT(Problem* _P, std::mt19937* _MT) : PIBT(_P, _MT)
+{
+  init();
+}
+
+pPIBT::~pPIBT() {}
+
+void pPIBT::init() {
+  if (G->getNodesNum() >= 0xffffff) {
+    std::cout << "error@pPIBT::init, too many nodes, "
+              << G->getNodesNum() << "\n";
+    std::exit(1);
+  }
+  nodeWord = std::vector<std::atomic<uint64_t>>(G->getNodesNum());
+  seen = std::vector<int>(G->getNodesNum(), -1);
+  seenCnt = 0;
+  roundLimit = 32;
+  roundMax = 0;
+  rollbackCnt = 0;
+  fallbackCnt = 0;
+  setThreads(1);
+}
+
+void pPIBT::setThreads(int num) {
+  if (num < 1) {
+    std::cout << "error@pPIBT::setThreads, invalid number, " << num << "\n";
+    std::exit(1);
+  }
+  pool.reset(new ThreadPool(num));
+  MTs.clear();
+  for (int k = 0; k < num; ++k) MTs.emplace_back((*MT)());
+}
+
+void pPIBT::update() {
+  evictGoalFields();
+  updatePriority();
+  ++stepCnt;  // reset claims
+
+  // rank -> agent, stable for tie-break by index
+  int agentNum = A.size();
+  if (agentNum >= 0xffffff) {
+    std::cout << "error@pPIBT::update, too many agents, " << agentNum << "\n";
+    std::exit(1);
+  }
+  U.resize(agentNum);
+  std::iota(U.begin(), U.end(), 0);
+  std::stable_sort(U.begin(), U.end(),
+                   [this] (int i, int j)
+                   { return this->priority[i] > this->priority[j]; });
+
+  // workers only read distance fields
+  for (auto a : A) {
+    if (a->hasGoal()) goalField(a->getGoal());
+  }
+
+  if (agentWord.size() != agentNum) {
+    agentWord = std::vector<std::atomic<uint64_t>>(agentNum);
+    aborted = std::vector<std::atomic<bool>>(agentNum);
+    claimedNodes.resize(agentNum);
+    claimedAgents.resize(agentNum);
+  }
+  // stamps wrap around, clear words once
+  if ((stepCnt & 0xffff) == 0) {
+    for (auto& w : nodeWord) w = 0;
+    for (auto& w : agentWord) w = 0;
+  }
+  for (int r = 0; r < agentNum; ++r) {
+    aborted[r] = false;
+    claimedNodes[r].clear();
+    claimedAgents[r].clear();
+  }
+
+  std::vector<int> pending(agentNum);
+  std::iota(pending.begin(), pending.end(), 0);
+  int round = 0;
+  while (!pending.empty() && round < roundLimit) {
+    ++round;
+
+    queue.swap(pending);
+    head = 0;
+    pool->run(pool->size(), [this] (int) { this->work(); });
+
+    // agents released by rolled back trees are planned again
+    for (int r = 0; r < agentNum; ++r) {
+      if (aborted[r]) release(r);
+    }
+    pending.clear();
+    for (int r = 0; r < agentNum; ++r) {
+      if (owner(agentWord[U[r]]) == -1) pending.push_back(r);
+    }
+  }
+  roundMax = std::max(roundMax, round);
+
+  if (pending.empty() && validate()) {
+    for (int i = 0; i < agentNum; ++i) {
+      moveAgent(i, G->getNodeFromIndex(next(agentWord[i])));
+    }
+    return;
+  }
+
+  // not settled, plan from scratch as PIBT, positions are still unchanged
+  ++fallbackCnt;
+  for (auto i : U) {
+    if (!isDecided(i)) priorityInheritance(i);
+  }
+}
+
+// an idle worker takes the highest root left
+void pPIBT::work() {
+  std::mt19937* rng = &MTs[ThreadPool::getWorkerId()];
+  int k;
+  while ((k = head++) < queue.size()) plan(queue[k], rng);
+}
+
+int pPIBT::tag(uint64_t w) {
+  if ((int)(w >> 48) != (stepCnt & 0xffff)) return -1;
+  return (int)((w >> 24) & 0xffffff) - 1;
+}
+
+int pPIBT::owner(uint64_t w) {
+  int r = tag(w);
+  if (r == -1 || aborted[r]) return -1;
+  return r;
+}
+
+// 1 -> newly claimed, 0 -> already claimed by the tree,
+// -1 -> kept by a higher tree, force -> the higher tree is rolled back
+int pPIBT::claim(std::atomic<uint64_t>& cell, int r, bool force) {
+  uint64_t w = cell.load();
+  int o;
+  while (true) {
+    o = owner(w);
+    if (o == r) return 0;
+    if (o != -1) {
+      if (o < r && !force) return -1;
+      rollback(o);
+    }
+    if (cell.compare_exchange_weak(w, word(r))) return 1;
+  }
+}
+
+void pPIBT::rollback(int r) {
+  if (!aborted[r].exchange(true)) ++rollbackCnt;
+}
+
+// a rolled back tree can no longer write the next node of a lost agent
+bool pPIBT::setNext(int i, int r, Node* v) {
+  uint64_t w = agentWord[i].load();
+  while (owner(w) == r) {
+    if (agentWord[i].compare_exchange_weak(w, word(r) | (v->getIndex() + 1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// called between rounds, claims taken over by other trees are left
+void pPIBT::release(int r) {
+  for (auto k : claimedNodes[r]) {
+    if (tag(nodeWord[k]) == r) nodeWord[k] = 0;
+  }
+  for (auto i : claimedAgents[r]) {
+    if (tag(agentWord[i]) == r) agentWord[i] = 0;
+  }
+  claimedNodes[r].clear();
+  claimedAgents[r].clear();
+  aborted[r] = false;
+}
+
+void pPIBT::plan(int r, std::mt19937* rng) {
+  int i = U[r];
+  if (claim(agentWord[i], r, false) != 1) return;  // decided by a higher tree
+  claimedAgents[r].push_back(i);
+  Nodes C = candidates(i, nullptr, r);
+  inherit(i, C, r, rng);
+}
+
+// nodes claimed by lower trees are candidates as well
+Nodes pPIBT::candidates(int i, Node* tmp, int r) {
+  Nodes C;
+  Node* u = A[i]->getNode();
+  int o;
+  for (auto v : G->neighbor(u)) {
+    if (v == tmp) continue;
+    o = owner(nodeWord[v->getIndex()]);
+    if (o == -1 || o > r) C.push_back(v);
+  }
+  o = owner(nodeWord[u->getIndex()]);
+  if (o == -1 || o > r) C.push_back(u);
+  return C;
+}
+
+bool pPIBT::inherit(int i, Nodes& C, int r, std::mt19937* rng) {
+  Agent* a = A[i];
+  Node* u = a->getNode();
+  Node* target;
+  int j, s;
+
+  while (!C.empty()) {
+    if (aborted[r]) return false;  // the tree is planned again
+
+    target = chooseNode(a, C, rng);
+    s = claim(nodeWord[target->getIndex()], r, false);
+    if (s != 1) {  // reserved meanwhile
+      C.erase(std::find(C.begin(), C.end(), target));
+      continue;
+    }
+    claimedNodes[r].push_back(target->getIndex());
+    if (!setNext(i, r, target)) return false;  // rolled back
+
+    // if there is an agent
+    j = occupied[target->getIndex()];
+    if (j != -1 && j != i) {
+      s = claim(agentWord[j], r, false);
+      if (s == 1) {
+        // undecided or decided by a lower tree, priority inheritance
+        claimedAgents[r].push_back(j);
+        Nodes Cj = candidates(j, u, r);
+        if (inherit(j, Cj, r, rng)) return true;
+        // priority inheritance fail
+        auto itr = std::remove_if(C.begin(), C.end(),
+                                  [this, r] (Node* v) {
+                                    int o = this->owner(this->nodeWord[v->getIndex()]);
+                                    return o != -1 && o <= r; });
+        C.erase(itr, C.end());
+        continue;
+      }
+      // the next node is written before reading the other's,
+      // so at least one of two agents swapping notices it
+      if (s == -1 && next(agentWord[j]) == u->getIndex()) {
+        C.erase(std::find(C.begin(), C.end(), target));
+        continue;
+      }
+    }
+    return true;
+  }
+
+  // failed, stay even if a stale tree takes the node
+  if (aborted[r]) return false;
+  if (claim(nodeWord[u->getIndex()], r, true) == 1) {
+    claimedNodes[r].push_back(u->getIndex());
+  }
+  setNext(i, r, u);
+  return false;
+}
+
+// one agent on each node and no swap
+bool pPIBT::validate() {
+  ++seenCnt;
+  int k, j;
+  for (int i = 0; i < A.size(); ++i) {
+    k = next(agentWord[i]);
+    if (k == -1 || seen[k] == seenCnt) return false;
+    seen[k] = seenCnt;
+    j = occupied[k];
+    if (j != -1 && j != i && next(agentWord[j]) == A[i]->getNode()->getIndex()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string pPIBT::logStr() {
+  std::string str;
+  str += "[solver] type:pPIBT\n";
+  str += "[solver] threads:" + std::to_string(pool->size()) + "\n";
+  str += "[solver] round_max:" + std::to_string(roundMax) + "\n";
+  str += "[solver] rollback:" + std::to_string(rollbackCnt) + "\n";
+  str += "[solver] fallback:" + std::to_string(fallbackCnt) + "\n";
+  str += Solver::logStr();
+  return str;
+}
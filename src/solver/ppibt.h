@@ -0,0 +1,76 @@
+/*
+ * ppibt.h
+ *
+ * Purpose: PIBT with inheritance trees planned in parallel
+ *
+ * Workers take roots from one shared queue in priority order. Nodes and
+ * agents are claimed by CAS on per-node/per-agent words. When a claim
+ * collides, the tree with lower priority is rolled back and planned again
+ * in the next round.
+ *
+ * Experimental, no speedup over PIBT has been measured so far.
+ * The deadline mode of PIBT is not supported.
+ */
+
+#pragma once
+#include "pibt.h"
+#include "../util/threadpool.h"
+#include <atomic>
+#include <memory>
+
+
+class pPIBT : public PIBT {
+private:
+  std::unique_ptr<ThreadPool> pool;
+  std::vector<std::mt19937> MTs;  // tie-breakers, one per worker
+
+  // claim words, 16 bits of stepCnt | rank of tree + 1 | node index + 1,
+  // rank 0 is the top, only words of agents hold the next node
+  std::vector<int> U;  // rank -> root agent, priority order
+  std::vector<std::atomic<uint64_t>> nodeWord;   // node index -> tree
+  std::vector<std::atomic<uint64_t>> agentWord;  // agent -> tree, next node
+  std::vector<std::atomic<bool>> aborted;  // rank -> rolled back
+  std::vector<std::vector<int>> claimedNodes;   // rank -> nodes to release
+  std::vector<std::vector<int>> claimedAgents;  // rank -> agents to release
+
+  // ranks to be planned in priority order, shared by workers
+  std::vector<int> queue;
+  std::atomic<int> head;
+
+  std::vector<int> seen;  // seen[v] == seenCnt -> v is planned, for validation
+  int seenCnt;
+
+  int roundLimit;  // fall back to PIBT::update over this
+  int roundMax;
+  std::atomic<int> rollbackCnt;
+  int fallbackCnt;
+
+  void init();
+
+  uint64_t word(int r) {
+    return ((uint64_t)(stepCnt & 0xffff) << 48) | ((uint64_t)(r + 1) << 24);
+  }
+  int tag(uint64_t w);    // -1 -> free
+  int owner(uint64_t w);  // -1 -> free, including rolled back trees
+  int next(uint64_t w) { return (int)(w & 0xffffff) - 1; }
+  int claim(std::atomic<uint64_t>& cell, int r, bool force);
+  bool setNext(int i, int r, Node* v);
+  void rollback(int r);
+  void release(int r);
+
+  void work();
+  void plan(int r, std::mt19937* rng);
+  Nodes candidates(int i, Node* tmp, int r);
+  bool inherit(int i, Nodes& C, int r, std::mt19937* rng);
+  bool validate();
+
+public:
+  pPIBT(Problem* _P);
+  pPIBT(Problem* _P, std::mt19937* _MT);
+  ~pPIBT();
+
+  void setThreads(int num);
+  void update();
+
+  std::string logStr();
+};
@@ -35,6 +35,40 @@ void PPS::init() {
   for (auto v : G->getNodes()) {
     if (G->neighbor(v).size() >= 3) deg3nodes.push_back(v);
   }
+
+  // setup indexes
+  int nodeNum = G->getNodesNum();
+  occupant = std::vector<Agent*>(nodeNum, nullptr);
+  for (auto a : A) occupant[a->getNode()->getIndex()] = a;
+  L = std::vector<int>(nodeNum, 0);
+  moved = std::vector<int>(A.size(), -1);
+  moveStamp = 0;
+  swapersOf.resize(A.size());
+  sortedEsvs.resize(nodeNum);
+  esvLimit = 16;
+}
+
+// each agent is on one node after a step, transient overlap is allowed
+void PPS::setNode(Agent* a, Node* v) {
+  if (occupant[a->getNode()->getIndex()] == a) {
+    occupant[a->getNode()->getIndex()] = nullptr;
+  }
+  a->setNode(v);
+  occupant[v->getIndex()] = a;
+}
+
+void PPS::joinS(Agent* a, S* s) {
+  swapersOf[a->getId()].push_back(s);
+}
+
+void PPS::leaveS(Agent* a, S* s) {
+  auto& lst = swapersOf[a->getId()];
+  lst.erase(std::find(lst.begin(), lst.end(), s));
+}
+
+void PPS::setDone(S* s) {
+  s->done = true;
+  doneSwapers.push_back(s);
 }
 
 bool PPS::solve() {
@@ -43,7 +77,7 @@ bool PPS::solve() {
   // l.1, initialize
   pushers = A;
   U.clear();
-  L.clear();
+  for (auto& cnt : L) cnt = 0;
 
   while (!P->isSolved()) {  // l.2
     update();
@@ -60,7 +94,7 @@ bool PPS::solve() {
 }
 
 void PPS::update() {
-  M.clear();  // l.3
+  ++moveStamp;  // l.3, clear M
 
   for (auto s : swapers) {  // l.4
     H.clear();
@@ -108,6 +142,7 @@ void PPS::update() {
   for (auto s : doneSwapers) {
     auto itr = std::find(swapers.begin(), swapers.end(), s);
     swapers.erase(itr);
+    for (auto a : s->agents) leaveS(a, s);
     delete s;
   }
   doneSwapers.clear();
@@ -121,7 +156,7 @@ RES PPS::PUSH(Agent* c, bool swap) {
 
 RES PPS::PUSH(Agent* c, Nodes &T, bool swap) {
   if (inArray(c, H)) return RES::FAIL;   // l.1
-  if (inArray(c, M)) return RES::PAUSE;  // l.2
+  if (isMoved(c)) return RES::PAUSE;  // l.2
   if (swap == false && inArray(c, U)) return PAUSE;  // l.3
 
   auto itrU = std::find(U.begin(), U.end(), c);
@@ -132,7 +167,7 @@ RES PPS::PUSH(Agent* c, Nodes &T, bool swap) {
   if (isTmpGoals[c->getId()]) {  // l.5, used when swapping, case 3
     S* s = getS(c);
     // error check
-    if (!inArray(s, doneSwapers) && s->phase != SWAPPHASE::CLEARING) {
+    if (!s->done && s->phase != SWAPPHASE::CLEARING) {
       std::cout << "error@PPS::PUSH, invalid swap phase, s : "
                 << s->id << ", phase : " << s->phase << "\n";
       std::exit(1);
@@ -163,7 +198,7 @@ RES PPS::PUSH(Agent* c, Nodes &T, bool swap) {
 
   if (attempt == RES::SUCCESS) {  // l.17
     move(c, pi);  // l.18
-    M.push_back(c);  // l.18
+    setMoved(c);  // l.18
   }
 
   return attempt;  // l.19
@@ -175,8 +210,8 @@ RES PPS::PUSH(S* s) {
   Agent* aL = s->agents[1];
   Node* target = s->esv[0];
 
-  if (inArray(aH, M)) return RES::PAUSE;
-  if (inArray(aL, M)) return RES::PAUSE;
+  if (isMoved(aH)) return RES::PAUSE;
+  if (isMoved(aL)) return RES::PAUSE;
 
   // check which is the nearest
   if (s->agents.size() == 2) {
@@ -197,7 +232,7 @@ RES PPS::PUSH(S* s) {
 
   if (attempt == RES::SUCCESS) {  // l.17
     move(s, pi);  // l.18
-    for (auto a : s->agents) M.push_back(a);  // l.18
+    for (auto a : s->agents) setMoved(a);  // l.18
   }
 
   return attempt;  // l.19
@@ -207,25 +242,22 @@ RES PPS::FEASIBLE(Agent* c, Nodes &pi, Nodes &T, bool swap) {
   if (pi.size() < 2) return RES::FAIL;  // l.1
   Node* v = pi[1];  // l.2
 
-  if (inArray(c, M)) {
+  if (isMoved(c)) {
     return RES::FAIL;
   }
 
-  if (reserved(v, M)) {  // l.3
+  if (reserved(v)) {  // l.3
     return RES::PAUSE;  // l.4
   }
 
-  if (inArray(v, L)) {  // l.5, reserved
+  if (isReserved(v)) {  // l.5, reserved
     return RES::PAUSE;  // l.6
   }
 
-  auto itrA = std::find_if(A.begin(), A.end(),
-                           [v] (Agent* a) { return a->getNode() == v; });
+  Agent* a = getOccupant(v);
   Nodes pi_one, pi_two;
-  Agent* a = nullptr;
 
-  if (itrA != A.end() && swap == false) {  // l.10
-    a = *itrA;
+  if (a != nullptr && swap == false) {  // l.10
     if (inS(a)) return RES::FAIL;  // l.11
 
     pi_one = SHORTEST_PATH(c->getNode(), c->getGoal());  // l.12
@@ -236,8 +268,7 @@ RES PPS::FEASIBLE(Agent* c, Nodes &pi, Nodes &T, bool swap) {
       return RES::FAIL;  // l.18
     }
 
-  } else if (itrA != A.end() && swap == true) {  // l.19
-    a = *itrA;
+  } else if (a != nullptr && swap == true) {  // l.19
     if (inS(a)) {  // l.20
       Agent* origin = c;
       if (!H.empty()) origin = H[0];
@@ -247,11 +278,10 @@ RES PPS::FEASIBLE(Agent* c, Nodes &pi, Nodes &T, bool swap) {
         }
       }
     }
-  } else if (itrA == A.end()) {
+  } else if (a == nullptr) {
     return RES::SUCCESS;  // l.23
   }
 
-  a = *itrA;
   H.push_back(c);
   return PUSH(a, T, swap);  // l.24, recursive push
 }
@@ -260,24 +290,20 @@ RES PPS::FEASIBLE(S* s, Nodes &pi) {
   if (pi.size() < 2) return RES::FAIL;  // l.1
   Node* v = pi[1];  // l.2
 
-  if (reserved(v, M)) return RES::PAUSE;  // l.3, 4
-  if (inArray(v, L))  return RES::PAUSE;  // l.5, 6
+  if (reserved(v)) return RES::PAUSE;  // l.3, 4
+  if (isReserved(v)) return RES::PAUSE;  // l.5, 6
 
-  auto itrA = std::find_if(A.begin(), A.end(),
-                           [v](Agent* a) { return a->getNode() == v; });
-  Agent* a;
-  if (itrA != A.end()) {  // l.19
-    a = *itrA;
+  Agent* a = getOccupant(v);
+  if (a != nullptr) {  // l.19
     if (inS(a)) {  // l.20
       if (CHECK_PRIORITY(s, a) == CHECK::INVALID) {  // l.21
         return RES::FAIL;  // l.22
       }
     }
-  } else if (itrA == A.end()) {
+  } else if (a == nullptr) {
     return RES::SUCCESS;  // l.23
   }
 
-  a = *itrA;
   H.push_back(s->agents[0]);
   H.push_back(s->agents[1]);
   return PUSH(a, true);  // l.24, recursive push
@@ -307,7 +333,7 @@ CHECK PPS::CHECK_SWAPER(S* s) {
   }
 
   // check temporaly resolved by other swapers
-  if (inArray(s, doneSwapers)) {
+  if (s->done) {
     return CHECK::INVALID;
   }
 
@@ -343,7 +369,7 @@ CHECK PPS::CHECK_GOAL(Agent* a) {
 }
 
 void PPS::ADD_DONE_SWAPERS(S* s) {
-  doneSwapers.push_back(s);
+  setDone(s);
   Agents agents = s->agents;
   if (agents.size() == 3) {
     Agent* a3 = agents[2];
@@ -368,7 +394,7 @@ Nodes PPS::SHORTEST_PATH(Node* s, Node* g) {
   return G->getPath(s, g);
 }
 
-Nodes PPS::SHORTEST_PATH(Node* s, Node* g, Nodes prohibited) {
+Nodes PPS::SHORTEST_PATH(Node* s, Node* g, const Nodes& prohibited) {
   return G->getPath(s, g, prohibited);
 }
 
@@ -380,7 +406,7 @@ Nodes PPS::SHORTEST_PATH(Agent* c, Node* g) {
   return G->getPath(c->getNode(), g, prohibited);
 }
 
-Nodes PPS::SHORTEST_PATH(Agent* c, Node* g, Nodes& T) {
+Nodes PPS::SHORTEST_PATH(Agent* c, Node* g, const Nodes& T) {
   if (H.empty()) return G->getPath(c->getNode(), g, T);
 
   Nodes prohibited = T;
@@ -414,8 +440,8 @@ RES PPS::SWAP(S* s) {
           SWAP(s);
         } else {
           // for avoid collision
-          M.push_back(aH);
-          M.push_back(aL);
+          setMoved(aH);
+          setMoved(aL);
         }
       }
     }
@@ -429,6 +455,7 @@ RES PPS::SWAP(S* s) {
     if (attempt == RES::FAIL) {  // l.12
 
       s->agents.erase(s->agents.end() - 1);  // l.13, pop
+      leaveS(a, s);
       isTmpGoals[a->getId()] = false;
       P->assign(a->getTask());
       a->releaseTask();
@@ -448,6 +475,7 @@ RES PPS::SWAP(S* s) {
       if (a->getNode() == a->getGoal()) {
 
         s->agents.erase(s->agents.end() - 1);  // l.17
+        leaveS(a, s);
         P->assign(a->getTask());
         a->releaseTask();
         a->setGoal(goals[a->getId()]);  // l.17
@@ -487,7 +515,8 @@ RES PPS::FIND_NEW_VERTEX(S* s) {
     std::exit(1);
   }
 
-  if (s->esv.empty()) {
+  // the last candidate is kept, swapers always read esv[0]
+  if (s->esv.size() <= 1) {
     return RES::FAIL;
   }
 
@@ -522,7 +551,7 @@ void PPS::move(Agent* a, Nodes &pi) {
     std::exit(1);
   }
 
-  a->setNode(pi[1]);
+  setNode(a, pi[1]);
 }
 
 void PPS::move(S* s, Nodes &pi) {
@@ -533,8 +562,8 @@ void PPS::move(S* s, Nodes &pi) {
     std::exit(1);
   }
 
-  s->agents[0]->setNode(pi[1]);
-  s->agents[1]->setNode(pi[0]);
+  setNode(s->agents[0], pi[1]);
+  setNode(s->agents[1], pi[0]);
 }
 
 void PPS::SWAP_PRIMITIVES(S* s) {
@@ -556,33 +585,33 @@ void PPS::SWAP_PRIMITIVES(S* s) {
   Agent* aH = s->agents[0];
   Agent* aL = s->agents[1];
 
-  if (inArray(aH, M) || inArray(aL, M)) {
-    M.push_back(aH);
-    M.push_back(aL);
+  if (isMoved(aH) || isMoved(aL)) {
+    setMoved(aH);
+    setMoved(aL);
     return;
   }
 
   switch (s->phase) {
   case SWAPPHASE::EVAC_H:
-    aH->setNode(s->evacH);
-    aL->setNode(s->target);
+    setNode(aH, s->evacH);
+    setNode(aL, s->target);
     s->phase = SWAPPHASE::EVAC_L;
     break;
   case SWAPPHASE::EVAC_L:
-    aH->setNode(s->target);
-    aL->setNode(s->evacL);
+    setNode(aH, s->target);
+    setNode(aL, s->evacL);
     s->phase = SWAPPHASE::SWAP_DONE;
     break;
   case SWAPPHASE::SWAP_DONE:
-    aH->setNode(s->origin);
-    aL->setNode(s->target);
+    setNode(aH, s->origin);
+    setNode(aL, s->target);
     FINISH_SWAP(s);
     break;
   default:
     break;
   }
-  M.push_back(aH);
-  M.push_back(aL);
+  setMoved(aH);
+  setMoved(aL);
 }
 
 bool PPS::DEPEND(Nodes piA, Nodes piB) {
@@ -594,14 +623,21 @@ bool PPS::DEPEND(Nodes piA, Nodes piB) {
   return false;
 }
 
-Nodes PPS::getSortedEsv(Agent* c) {
-  Nodes lst = deg3nodes;
-  Graph* _G = G;
+// the nearest esvLimit nodes, computed once per node
+const Nodes& PPS::getSortedEsv(Agent* c) {
   Node* v = c->getNode();
+  Nodes& lst = sortedEsvs[v->getIndex()];
+  if (!lst.empty()) return lst;
+
   // actually, should use pathDist, but for fast implementation
-  std::sort(lst.begin(), lst.end(),
-            [_G, v] (Node* v1, Node* v2)
-            { return _G->dist(v, v1) < _G->dist(v, v2); });
+  std::vector<std::pair<int, int>> ds;  // (distance, index of deg3nodes)
+  ds.reserve(deg3nodes.size());
+  for (int i = 0; i < deg3nodes.size(); ++i) {
+    ds.emplace_back(G->dist(v, deg3nodes[i]), i);
+  }
+  int k = std::min(esvLimit, (int)ds.size());
+  std::partial_sort(ds.begin(), ds.begin() + k, ds.end());
+  for (int i = 0; i < k; ++i) lst.push_back(deg3nodes[ds[i].second]);
   return lst;
 }
 
@@ -612,7 +648,7 @@ void PPS::SETUP_SWAP(Agent* c, Agent* a) {
     std::exit(1);
   }
 
-  Nodes sorted_esv = getSortedEsv(c);  // l.14
+  const Nodes& sorted_esv = getSortedEsv(c);  // l.14
   Node* v = sorted_esv[0];
   Agents agents;
   if (pathDist(c->getNode(), v) <= pathDist(a->getNode(), v)) {
@@ -630,8 +666,10 @@ void PPS::SETUP_SWAP(Agent* c, Agent* a) {
                  nullptr,  // evacH
                  nullptr,  // evacL
                  {},       // area
-                 SWAPPHASE::GO_TARGET };
+                 SWAPPHASE::GO_TARGET,
+                 false };  // done
   ++s_uuid;
+  for (auto b : agents) joinS(b, s);
 
   pusherToSwaper.push_back(c);
   pusherToSwaper.push_back(a);
@@ -648,18 +686,14 @@ void PPS::FINISH_SWAP(S* s) {
   }
 
   // clear L
-  auto itrL = std::find(L.begin(), L.end(), s->target);
-  L.erase(itrL);
-  itrL = std::find(L.begin(), L.end(), s->origin);
-  L.erase(itrL);
-  itrL = std::find(L.begin(), L.end(), s->evacH);
-  L.erase(itrL);
-  itrL = std::find(L.begin(), L.end(), s->evacL);
-  L.erase(itrL);
+  release(s->target);
+  release(s->origin);
+  release(s->evacH);
+  release(s->evacL);
 
   swaperToPusher.push_back(s->agents[0]);
   swaperToPusher.push_back(s->agents[1]);
-  doneSwapers.push_back(s);
+  setDone(s);
 }
 
 bool PPS::CLEAR(S* s) {
@@ -705,12 +739,11 @@ bool PPS::CLEAR(S* s) {
   // case 2. try push
   if (!evacL) {
     for (auto v : neighbor) {
-      if (inArray(v, L)) continue;
+      if (isReserved(v)) continue;
       if (v == aLPos) continue;
       if (evacH && v == evacH) continue;
 
-      Agent* a = *std::find_if(A.begin(), A.end(),
-                               [v](Agent* a) { return a->getNode() == v; });
+      Agent* a = getOccupant(v);
       H.push_back(aH);
       H.push_back(aL);
       Nodes T = { evacH };
@@ -731,16 +764,14 @@ bool PPS::CLEAR(S* s) {
   // case 3. evac
   if (evacH && !evacL) {
     for (auto v : neighbor) {
-      if (inArray(v, L)) continue;
+      if (isReserved(v)) continue;
       if (v == aLPos) continue;
 
       // occuping agents
-      auto itrU = std::find_if(A.begin(), A.end(),
-                               [v](Agent* a) { return a->getNode() == v; });
-      if (itrU == A.end()) continue;
-      Agent* a3 = *itrU;
+      Agent* a3 = getOccupant(v);
+      if (a3 == nullptr) continue;
 
-      if (inArray(a3, M)) continue;
+      if (isMoved(a3)) continue;
       if (inS(a3)) {
         if (CHECK_PRIORITY(s, a3) == CHECK::INVALID) {
           continue;
@@ -777,7 +808,7 @@ bool PPS::CLEAR(S* s) {
         // resolve swap target
         if (inS(a3)) {
           S* t = getS(a3);
-          doneSwapers.push_back(t);
+          setDone(t);
           for (auto b : t->agents) {
             b->setGoal(goals[b->getId()]);
             isTmpGoals[b->getId()] = false;
@@ -794,6 +825,7 @@ bool PPS::CLEAR(S* s) {
         isTmpGoals[a3->getId()] = true;
         pusherToSwaper.push_back(a3);
         s->agents.push_back(a3);
+        joinS(a3, s);
         s->phase = SWAPPHASE::CLEARING;
         PUSH(a3, true);  // to target
 
@@ -817,10 +849,10 @@ bool PPS::CLEAR(S* s) {
     s->evacH = evacH;
     s->evacL = evacL;
 
-    L.push_back(s->target);
-    L.push_back(s->origin);
-    L.push_back(s->evacH);
-    L.push_back(s->evacL);
+    reserve(s->target);
+    reserve(s->origin);
+    reserve(s->evacH);
+    reserve(s->evacL);
 
     return true;
 
@@ -834,38 +866,34 @@ bool PPS::CLEAR(S* s) {
   return false;
 }
 
-bool PPS::reserved(Node* v, Agents &M) {
-  return std::any_of(M.begin(), M.end(),
-                     [v](Agent* a) { return a->getNode() == v; });
+// whether an agent in M is on v
+bool PPS::reserved(Node* v) {
+  Agent* a = getOccupant(v);
+  return a != nullptr && isMoved(a);
 }
 
 bool PPS::isFree(Node* v) {
-  bool flg = std::none_of(A.begin(), A.end(),
-                          [v](Agent* a) { return a->getNode() == v; });
-  flg &= !inArray(v, L);
-  return flg;
+  return getOccupant(v) == nullptr && !isReserved(v);
 }
 
 bool PPS::inS(Agent* a) {
-  for (auto s : swapers) {
-    if (inArray(s, doneSwapers)) continue;
-    if (inArray(a, s->agents)) return true;
+  for (auto s : swapersOf[a->getId()]) {
+    if (!s->done) return true;
   }
   return false;
 }
 
+// the oldest swaper including a, swapers are in creation order
 S* PPS::getS(Agent* a) {
-  auto itr = std::find_if(swapers.begin(), swapers.end(),
-                          [a] (S* s) {
-                            auto itrA = std::find(s->agents.begin(), s->agents.end(), a);
-                            return itrA != s->agents.end(); });
-  if (itr == swapers.end()) {
+  auto& lst = swapersOf[a->getId()];
+  if (lst.empty()) {
     std::cout << "error@PPS::getS, "
               << "corresponding swaper does not exist, "
               << "agent : " << a->getId() << "\n";
     std::exit(1);
   }
-  return *itr;
+  return *std::min_element(lst.begin(), lst.end(),
+                           [] (S* s1, S* s2) { return s1->id < s2->id; });
 }
 
 CHECK PPS::CHECK_PRIORITY(Agent* c, Agent* a) {
@@ -893,13 +921,9 @@ struct VD {
 };
 
 Nodes PPS::CLOSEST_EMPTY_VERTICLES(Agent* c) {
-  Nodes empties;
-  Nodes occupied;
   Nodes Y;
   Nodes C;
 
-  // create occupied lists
-  for (auto a : A) occupied.push_back(a->getNode());
   std::unordered_map<int, VD*> table;
   VD* n = new VD { c->getNode(), 0 };
   int id = n->v->getId();
@@ -916,7 +940,7 @@ Nodes PPS::CLOSEST_EMPTY_VERTICLES(Agent* c) {
     n = table.at(id);
 
     // check empty or not
-    if (!inArray(n->v, occupied)) {
+    if (getOccupant(n->v) == nullptr) {
       if (Y.empty()) {
         d = n->d;
       } else if (d < n->d) {
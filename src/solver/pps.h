@@ -30,6 +30,7 @@ struct S {
   Node* evacL;  // [low]  evacuation node
   Nodes area;   // swap area, using case 3
   SWAPPHASE phase;  // phase
+  bool done;  // in doneSwapers
 };
 
 class PPS : public Solver {
@@ -40,15 +41,22 @@ private:
   Agents swaperToPusher;  // tmp
   std::vector<S*> doneSwapers;  // tmp
 
-  Agents M;  // moved agents
   Agents U;  // goal agents
-  Nodes L;   // reserved nodes
   Agents H;  // previous pusher
   bool status;  // continue or not
 
+  // indexes, updated on every move
+  std::vector<Agent*> occupant;   // node index -> agent, nullptr -> empty
+  std::vector<int> L;             // node index -> count of reservation
+  std::vector<int> moved;         // agent id -> moveStamp when moved, M
+  int moveStamp;
+  std::vector<std::vector<S*>> swapersOf;  // agent id -> swapers including it
+
   Nodes goals;  // final goal
   std::vector<bool> isTmpGoals;  // has temp goal
   Nodes deg3nodes;
+  std::vector<Nodes> sortedEsvs;  // node index -> nearest deg3nodes by dist
+  int esvLimit;                   // size of each sortedEsvs
 
   static int s_uuid;
 
@@ -65,8 +73,8 @@ private:
 
   Nodes SHORTEST_PATH(Node* s, Node* g);
   Nodes SHORTEST_PATH(Agent* c, Node* g);
-  Nodes SHORTEST_PATH(Node* s, Node* g, Nodes prohibited);
-  Nodes SHORTEST_PATH(Agent* c, Node* g, Nodes& T);
+  Nodes SHORTEST_PATH(Node* s, Node* g, const Nodes& prohibited);
+  Nodes SHORTEST_PATH(Agent* c, Node* g, const Nodes& T);
 
   bool DEPEND(Nodes piA, Nodes piB);
 
@@ -79,12 +87,24 @@ private:
 
   void move(Agent* a, Nodes &pi);
   void move(S* s, Nodes &pi);
+  void setNode(Agent* a, Node* v);
+  Agent* getOccupant(Node* v) { return occupant[v->getIndex()]; }
+
+  void setMoved(Agent* a) { moved[a->getId()] = moveStamp; }
+  bool isMoved(Agent* a) { return moved[a->getId()] == moveStamp; }
+  void reserve(Node* v) { ++L[v->getIndex()]; }
+  void release(Node* v) { --L[v->getIndex()]; }
+  bool isReserved(Node* v) { return L[v->getIndex()] > 0; }
+
+  void joinS(Agent* a, S* s);
+  void leaveS(Agent* a, S* s);
+  void setDone(S* s);
 
-  bool reserved(Node* v, Agents &M);
+  bool reserved(Node* v);
   bool isFree(Node* v);
   bool inS(Agent* a);
   S* getS(Agent* a);
-  Nodes getSortedEsv(Agent* c);
+  const Nodes& getSortedEsv(Agent* c);
 
   CHECK CHECK_PRIORITY(S* s, Agent* a);
   CHECK CHECK_PRIORITY(Agent* c, Agent* a);
@@ -0,0 +1,149 @@
+/*
+ * reservation.cpp
+ *
+ * Purpose: space-time reservation table shared by path planners
+ */
+
+#include "reservation.h"
+
+
+ReservationTable::ReservationTable(int nodeNum) : ReservationTable(nodeNum, 16)
+{
+}
+
+ReservationTable::ReservationTable(int nodeNum, int window) {
+  int size = 1;
+  while (size < window + 2) size <<= 1;
+  slices = std::vector<Slice>(size);
+  for (auto& s : slices) s.t = -1;
+  tMin = 0;
+  lastTime = std::vector<int>(nodeNum, -1);
+}
+
+long long ReservationTable::edgeKey(Node* u, Node* v) {
+  return ((long long)u->getIndex() << 32) | (long long)v->getIndex();
+}
+
+ReservationTable::Slice* ReservationTable::getSlice(int t) {
+  if (t < tMin || t >= tMin + (int)slices.size()) return nullptr;
+  Slice* s = &slices[t % slices.size()];
+  if (s->t != t) return nullptr;
+  return s;
+}
+
+// slice to write, nullptr when t is already released
+ReservationTable::Slice* ReservationTable::touchSlice(int t) {
+  if (t < tMin) return nullptr;
+  if (t >= tMin + (int)slices.size()) grow(t);
+  Slice* s = &slices[t % slices.size()];
+  if (s->t != t) {
+    s->t = t;
+    s->vertices.clear();
+    s->edges.clear();
+  }
+  return s;
+}
+
+void ReservationTable::grow(int t) {
+  int size = slices.size();
+  while (t >= tMin + size) size <<= 1;
+
+  std::vector<Slice> newSlices(size);
+  for (auto& s : newSlices) s.t = -1;
+  for (auto& s : slices) {
+    if (s.t < tMin) continue;
+    newSlices[s.t % size] = std::move(s);
+  }
+  slices.swap(newSlices);
+}
+
+void ReservationTable::reserve(int t, Node* v, int id) {
+  Slice* s = touchSlice(t);
+  if (s == nullptr) return;
+  s->vertices.emplace(v->getIndex(), id);
+  int& last = lastTime[v->getIndex()];
+  if (last < t) last = t;
+}
+
+void ReservationTable::release(int t, Node* v, int id) {
+  Slice* s = getSlice(t);
+  if (s == nullptr) return;
+  auto range = s->vertices.equal_range(v->getIndex());
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (itr->second == id) {
+      s->vertices.erase(itr);
+      return;
+    }
+  }
+}
+
+void ReservationTable::reserve(int t, Node* u, Node* v, int id) {
+  if (u == v) return;  // staying is covered by vertices
+  Slice* s = touchSlice(t);
+  if (s == nullptr) return;
+  s->edges.emplace(edgeKey(u, v), id);
+}
+
+void ReservationTable::release(int t, Node* u, Node* v, int id) {
+  if (u == v) return;
+  Slice* s = getSlice(t);
+  if (s == nullptr) return;
+  auto range = s->edges.equal_range(edgeKey(u, v));
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (itr->second == id) {
+      s->edges.erase(itr);
+      return;
+    }
+  }
+}
+
+void ReservationTable::reservePath(const Nodes& path, int startTime, int id) {
+  for (int k = 0; k < path.size(); ++k) {
+    reserve(startTime + k, path[k], id);
+    if (k > 0) reserve(startTime + k, path[k-1], path[k], id);
+  }
+}
+
+bool ReservationTable::isOccupied(int t, Node* v, int id) {
+  Slice* s = getSlice(t);
+  if (s == nullptr) return false;
+  auto range = s->vertices.equal_range(v->getIndex());
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (itr->second != id) return true;
+  }
+  return false;
+}
+
+bool ReservationTable::isSwapped(int t, Node* u, Node* v, int id) {
+  if (u == v) return false;
+  Slice* s = getSlice(t);
+  if (s == nullptr) return false;
+  auto range = s->edges.equal_range(edgeKey(v, u));
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (itr->second != id) return true;
+  }
+  return false;
+}
+
+std::vector<int> ReservationTable::getAgents(int t, Node* v) {
+  std::vector<int> agents;
+  Slice* s = getSlice(t);
+  if (s == nullptr) return agents;
+  auto range = s->vertices.equal_range(v->getIndex());
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    agents.push_back(itr->second);
+  }
+  return agents;
+}
+
+void ReservationTable::releaseBefore(int t) {
+  int tEnd = std::min(t, tMin + (int)slices.size());
+  for (int _t = tMin; _t < tEnd; ++_t) {
+    Slice* s = &slices[_t % slices.size()];
+    if (s->t != _t) continue;
+    s->t = -1;
+    s->vertices.clear();
+    s->edges.clear();
+  }
+  if (t > tMin) tMin = t;
+}
@@ -0,0 +1,57 @@
+/*
+ * reservation.h
+ *
+ * Purpose: space-time reservation table shared by path planners
+ */
+
+#pragma once
+
+#include "../graph/graph.h"
+#include <unordered_map>
+#include <vector>
+
+
+class ReservationTable {
+private:
+  struct Slice {
+    int t;  // -1 -> unused
+    std::unordered_multimap<int, int> vertices;  // node index -> agent
+    std::unordered_multimap<long long, int> edges;  // (from, to) -> agent
+  };
+
+  std::vector<Slice> slices;  // ring, slice of time t at t % size
+  int tMin;                   // slices before tMin are released
+  std::vector<int> lastTime;  // node index -> latest reserved time
+
+  static long long edgeKey(Node* u, Node* v);
+  Slice* getSlice(int t);
+  Slice* touchSlice(int t);
+  void grow(int t);
+
+public:
+  ReservationTable(int nodeNum);
+  ReservationTable(int nodeNum, int window);
+  ~ReservationTable() {};
+
+  // vertex v at time t
+  void reserve(int t, Node* v, int id);
+  void release(int t, Node* v, int id);
+  // edge, from u at t-1 to v at t
+  void reserve(int t, Node* u, Node* v, int id);
+  void release(int t, Node* u, Node* v, int id);
+  // whole path, path[k] at startTime + k
+  void reservePath(const Nodes& path, int startTime, int id);
+
+  // whether someone other than id is at v at t
+  bool isOccupied(int t, Node* v, int id = -1);
+  // whether moving u -> v during [t-1, t] swaps with someone other than id
+  bool isSwapped(int t, Node* u, Node* v, int id = -1);
+  // agents at v at t
+  std::vector<int> getAgents(int t, Node* v);
+  // latest time of reservations at v, -1 -> never
+  // this is not decreased by release
+  int getLastTime(Node* v) { return lastTime[v->getIndex()]; }
+
+  // forget all reservations before t
+  void releaseBefore(int t);
+};
@@ -27,6 +27,13 @@ void Solver::init() {
   A = P->getA();
   int nodeNum = G->getNodesNum();
   dists = Eigen::MatrixXi::Zero(nodeNum, nodeNum);
+  lockDists = false;
+  goalFieldStamp.assign(nodeNum, 0);
+  goalFieldStampCnt = 0;
+  idleStamp.assign(nodeNum, 0);
+  idleStampCnt = 0;
+  pickupStamp = -1;
+  pickupHead = 0;
 }
 
 void Solver::solveStart() {
@@ -111,7 +118,7 @@ void Solver::WarshallFloyd() {
 int Solver::getMaxLengthPaths(Paths& paths) {
   if (paths.empty()) return 0;
   auto itr = std::max_element(paths.begin(), paths.end(),
-                              [] (Nodes p1, Nodes p2) {
+                              [] (const Nodes& p1, const Nodes& p2) {
                                 return p1.size() < p2.size(); });
   return itr->size();
 }
@@ -129,6 +136,9 @@ int Solver::pathDist(Node* s, Node* g) {
   // same place?
   if (s == g) return 0;
 
+  std::unique_lock<std::mutex> lock(distsMtx, std::defer_lock);
+  if (lockDists) lock.lock();
+
   // has already explored?
   int s_index = G->getNodeIndex(s);
   int g_index = G->getNodeIndex(g);
@@ -165,13 +175,166 @@ int Solver::pathDist(Node* s, Node* g) {
   return dist;
 }
 
-int Solver::pathDist(Node* s, Node* g, Nodes &prohibited) {
+int Solver::pathDist(Node* s, Node* g, const Nodes &prohibited) {
   // same place?
   if (s == g) return 0;
 
   return G->getPath(s, g, prohibited).size() - 1;
 }
 
+// BFS from the goal, shared among agents with the same goal
+// unreachable nodes have the value of nodeNum
+const std::vector<int>& Solver::goalField(Node* g) {
+  int gIndex = g->getIndex();
+  auto itr = goalFields.find(gIndex);
+  if (itr != goalFields.end()) return itr->second;
+
+  int nodeNum = G->getNodesNum();
+  bool directed = G->isDirected();
+
+  if (directed) buildPredecessors();
+
+  std::vector<int>& field = goalFields[gIndex];
+  field.assign(nodeNum, nodeNum);
+  std::vector<int> OPEN;
+  OPEN.reserve(nodeNum);
+  OPEN.push_back(gIndex);
+  field[gIndex] = 0;
+  int index, d;
+  for (int head = 0; head < OPEN.size(); ++head) {
+    index = OPEN[head];
+    d = field[index] + 1;
+    if (directed) {
+      for (auto k : predecessors[index]) {
+        if (field[k] != nodeNum) continue;
+        field[k] = d;
+        OPEN.push_back(k);
+      }
+    } else {
+      for (auto u : G->neighbor(G->getNodeFromIndex(index))) {
+        if (field[u->getIndex()] != nodeNum) continue;
+        field[u->getIndex()] = d;
+        OPEN.push_back(u->getIndex());
+      }
+    }
+  }
+  return field;
+}
+
+const std::vector<int>* Solver::findGoalField(Node* g) {
+  auto itr = goalFields.find(g->getIndex());
+  if (itr == goalFields.end()) return nullptr;
+  return &itr->second;
+}
+
+// reverse edges, built once
+void Solver::buildPredecessors() {
+  if (!predecessors.empty()) return;
+  predecessors.resize(G->getNodesNum());
+  for (auto v : G->getNodes()) {
+    for (auto u : G->neighbor(v)) {
+      predecessors[u->getIndex()].push_back(v->getIndex());
+    }
+  }
+}
+
+// idle agents head for the nearest pickup location of open tasks
+// one multi-source BFS from all pickups serves every idle agent,
+// it stops as soon as all of them are labeled and resumes from there
+// at later steps until open tasks change
+void Solver::allocate() {
+  if (P->allocated()) return;
+  const std::vector<Task*>& T = P->getT();
+
+  // collect idle agents
+  Agents idles;
+  for (auto a : A) {
+    if (!a->hasTask()) idles.push_back(a);
+  }
+  if (idles.empty()) return;
+
+  if (T.empty()) {
+    for (auto a : idles) a->releaseGoalOnly();
+    return;
+  }
+
+  int nodeNum = G->getNodesNum();
+  bool directed = G->isDirected();
+  if (directed) buildPredecessors();
+
+  int index;
+  if (pickupStamp != P->getOpenStamp()) {  // label from scratch
+    pickupStamp = P->getOpenStamp();
+    nearestPickup.assign(nodeNum, -1);
+    pickupQueue.clear();
+    pickupHead = 0;
+    for (auto tau : T) {
+      index = tau->getG()[0]->getIndex();
+      if (nearestPickup[index] != -1) continue;
+      nearestPickup[index] = index;
+      pickupQueue.push_back(index);
+    }
+  }
+
+  ++idleStampCnt;
+  int rest = 0;
+  for (auto a : idles) {
+    index = a->getNode()->getIndex();
+    if (idleStamp[index] == idleStampCnt) continue;
+    idleStamp[index] = idleStampCnt;
+    if (nearestPickup[index] == -1) ++rest;
+  }
+
+  for (; pickupHead < pickupQueue.size() && rest > 0; ++pickupHead) {
+    index = pickupQueue[pickupHead];
+    if (directed) {
+      for (auto k : predecessors[index]) {
+        if (nearestPickup[k] != -1) continue;
+        nearestPickup[k] = nearestPickup[index];
+        pickupQueue.push_back(k);
+        if (idleStamp[k] == idleStampCnt) --rest;
+      }
+    } else {
+      for (auto u : G->neighbor(G->getNodeFromIndex(index))) {
+        int k = u->getIndex();
+        if (nearestPickup[k] != -1) continue;
+        nearestPickup[k] = nearestPickup[index];
+        pickupQueue.push_back(k);
+        if (idleStamp[k] == idleStampCnt) --rest;
+      }
+    }
+  }
+
+  for (auto a : idles) {
+    index = nearestPickup[a->getNode()->getIndex()];
+    if (index == -1) {  // no reachable task
+      a->releaseGoalOnly();
+    } else {
+      a->setGoal(G->getNodeFromIndex(index));
+    }
+  }
+}
+
+// drop fields of goals which no agent holds, O(A) per call,
+// hence at most one field per agent is left
+void Solver::evictGoalFields() {
+  if (goalFields.empty()) return;
+
+  ++goalFieldStampCnt;
+  for (auto a : A) {
+    if (a->hasGoal()) {
+      goalFieldStamp[a->getGoal()->getIndex()] = goalFieldStampCnt;
+    }
+  }
+  for (auto itr = goalFields.begin(); itr != goalFields.end(); ) {
+    if (goalFieldStamp[itr->first] != goalFieldStampCnt) {
+      itr = goalFields.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+}
+
 std::string Solver::getKey(int t, Node* v) {
   std::string key = "";
   key += std::to_string(t);
@@ -180,10 +343,6 @@ std::string Solver::getKey(int t, Node* v) {
   return key;
 }
 
-std::string Solver::getKey(AN* n) {
-  return getKey(n->g, n->v);
-}
-
 std::string Solver::logStr() {
   std::string str;
 
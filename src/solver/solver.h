@@ -4,6 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include <chrono>
+#include <mutex>
 #include <eigen3/Eigen/Core>
 #include <unordered_map>
 #include <unordered_set>
@@ -22,15 +23,35 @@ protected:
   Graph* G;
 
   Eigen::MatrixXi dists;
+  bool lockDists;  // pathDist is called by several threads or not
+  std::mutex distsMtx;
+
+  // distance fields, goal index -> distance from each node to the goal
+  std::unordered_map<int, std::vector<int>> goalFields;
+  std::vector<std::vector<int>> predecessors;  // for directed graphs
+  std::vector<int> goalFieldStamp;
+  int goalFieldStampCnt;
+  const std::vector<int>& goalField(Node* g);
+  const std::vector<int>* findGoalField(Node* g);  // nullptr -> not built
+  void evictGoalFields();
+  void buildPredecessors();
+
+  // task allocation, node index -> nearest pickup of open tasks, -1 -> none
+  std::vector<int> nearestPickup;
+  std::vector<int> pickupQueue;  // BFS queue, kept to resume labeling
+  int pickupHead;
+  int pickupStamp;               // P->getOpenStamp() of the labeling
+  std::vector<int> idleStamp;
+  int idleStampCnt;
+  void allocate();
 
   void init();
   int getMaxLengthPaths(Paths& paths);
   void formalizePath(Paths& paths);
   int pathDist(Node* v, Node* u);
-  int pathDist(Node* s, Node* g, Nodes &prohibited);
+  int pathDist(Node* s, Node* g, const Nodes &prohibited);
   std::vector<Agents> findAgentBlock();
   static std::string getKey(int t, Node* v);
-  static std::string getKey(AN* n);
 
   virtual void solveStart();
   virtual void solveEnd();
@@ -33,10 +33,69 @@ void TP::init() {
 
   // initialize
   for (auto a : A) paths.push_back({ a->getNode() });
+
+  int nodeNum = G->getNodesNum();
+  reservation = new ReservationTable(nodeNum);
+  reservedLength = std::vector<int>(A.size(), 0);
+  pathEndCnt = std::vector<int>(nodeNum, 0);
+  for (auto a : A) {
+    pathEnds.push_back(a->getNode()->getIndex());
+    ++pathEndCnt[a->getNode()->getIndex()];
+  }
+  for (int i = 0; i < A.size(); ++i) registerPath(i);
+
+  deliveryCnt = std::vector<int>(nodeNum, 0);
+  pickupTasks.resize(nodeNum);
+  indexedTaskNum = 0;
 }
 
 TP::~TP() {
   endpoints.clear();
+  delete reservation;
+}
+
+// register new part of paths[i] to the reservation table and path ends
+void TP::registerPath(int i) {
+  for (int t = reservedLength[i]; t < paths[i].size(); ++t) {
+    reservation->reserve(t, paths[i][t], i);
+    if (t > 0) reservation->reserve(t, paths[i][t-1], paths[i][t], i);
+  }
+  reservedLength[i] = paths[i].size();
+
+  --pathEndCnt[pathEnds[i]];
+  pathEnds[i] = paths[i].back()->getIndex();
+  ++pathEndCnt[pathEnds[i]];
+}
+
+// new tasks are always appended to the tail of open tasks
+void TP::registerNewTasks() {
+  auto& T = P->getT();
+  for (; indexedTaskNum < T.size(); ++indexedTaskNum) {
+    Task* tau = T[indexedTaskNum];
+    auto gs = tau->getG();
+    ++deliveryCnt[gs.back()->getIndex()];
+    auto& bucket = pickupTasks[gs[0]->getIndex()];
+    if (bucket.empty()) pickupNodes.push_back(gs[0]->getIndex());
+    bucket.push_back(tau);
+  }
+}
+
+// call before the task leaves open tasks
+void TP::unregisterTask(Task* tau) {
+  auto gs = tau->getG();
+  --deliveryCnt[gs.back()->getIndex()];
+  auto& bucket = pickupTasks[gs[0]->getIndex()];
+  bucket.erase(std::find(bucket.begin(), bucket.end(), tau));
+  if (bucket.empty()) {
+    pickupNodes.erase(std::find(pickupNodes.begin(), pickupNodes.end(),
+                                gs[0]->getIndex()));
+  }
+  --indexedTaskNum;
+}
+
+// u is the end of some path other than ones ending at v
+bool TP::isBlocked(Node* u, Node* v) {
+  return u != v && pathEndCnt[u->getIndex()] > 0;
 }
 
 bool TP::solve() {
@@ -63,19 +122,20 @@ void TP::update() {
   Agent* a;
   Node* v;
   Task* tau;
-  std::vector<Task*> tasks;
+
+  reservation->releaseBefore(timestep - 1);
+  registerNewTasks();
 
   for (int i = 0; i < A.size(); ++i) {
     a = A[i];
 
     if (paths[i].size() <= timestep) {
       v = a->getNode();
-      tasks = getExecutableTask(a, timestep);  // l.7
-
-      if (!tasks.empty()) {  // l.8
-        tau = getNearestTask(a, tasks);  // l.9
+      tau = getNearestExecutableTask(a);  // l.7, l.9
 
+      if (tau != nullptr) {  // l.8
         a->setTask(tau);  // l.10
+        unregisterTask(tau);
         P->assign(tau);   // l.11
         if (tau->getG()[0] == a->getNode()) {  // when current place is pickup node
           tau->update(a->getNode());
@@ -87,6 +147,8 @@ void TP::update() {
       } else {
         updatePath2(a, timestep);  // l.16
       }
+
+      registerPath(i);
     }
 
     a->setNode(paths[i][timestep]);
@@ -94,14 +156,7 @@ void TP::update() {
 }
 
 bool TP::shouldAvoid(Agent* a, int timestep) {
-  Node* v = a->getNode();
-  Node* g;
-
-  for (auto tau : P->getT()) {
-    g = tau->getG()[tau->getG().size() - 1];  // delivery points
-    if (g == v) return true;
-  }
-  return false;
+  return deliveryCnt[a->getNode()->getIndex()] > 0;  // delivery points
 }
 
 void TP::updatePath1(Agent* a, int startTime) {
@@ -125,19 +180,11 @@ void TP::updatePath1(Agent* a, int startTime) {
 
 void TP::updatePath2(Agent* a, int startTime) {
   Nodes candidates;
-  std::vector<Task*> T = P->getT();
-  bool contained;
 
   // create candidates
   for (auto v : endpoints) {
-    contained = std::any_of(T.begin(), T.end(),
-                             [v](Task* tau) {
-                               return tau->getG()[tau->getG().size() - 1] == v; });
-    if (contained) continue;
-    contained = std::any_of(paths.begin(), paths.end(),
-                            [v](Nodes path) {
-                              return path[path.size() - 1] == v; });
-    if (contained) continue;
+    if (deliveryCnt[v->getIndex()] > 0) continue;
+    if (pathEndCnt[v->getIndex()] > 0) continue;
     candidates.push_back(v);
   }
 
@@ -167,42 +214,34 @@ void TP::updatePath2(Agent* a, int startTime) {
   paths[i].insert(paths[i].end(), path.begin() + 1, path.end());
 }
 
-std::vector<Task*> TP::getExecutableTask(Agent* a, int timestep) {
-  std::vector<Task*> tasks;
-  Nodes gs;
-  bool notContained;
+// nearest open task whose pickup and delivery are not ends of others' paths
+// ties are broken by the order of open tasks
+Task* TP::getNearestExecutableTask(Agent* a) {
   Node* v = a->getNode();
-  Node* u;
-
-  for (auto tau : P->getT()) {
-    notContained = true;
-    for (auto path : paths) {
-      u = path[path.size() - 1];  // end of the path
-      if (u == v) continue;
-      gs = tau->getG();
-      notContained &= std::none_of(gs.begin(), gs.end(),
-                                   [u] (Node* k) { return u == k; });
-      if (!notContained) break;
+  Task* nearest = nullptr;
+  int minDist = 0;
+  int d;
+
+  for (auto k : pickupNodes) {
+    Node* u = G->getNodeFromIndex(k);
+    if (isBlocked(u, v)) continue;
+    d = G->dist(v, u);
+    if (nearest != nullptr && d > minDist) continue;
+    for (auto tau : pickupTasks[k]) {
+      if (nearest != nullptr && d == minDist
+          && nearest->getId() < tau->getId()) break;
+      auto gs = tau->getG();
+      if (std::any_of(gs.begin() + 1, gs.end(),
+                      [this, v] (Node* g) { return this->isBlocked(g, v); })) {
+        continue;
+      }
+      nearest = tau;
+      minDist = d;
+      break;
     }
-    if (notContained) tasks.push_back(tau);
   }
 
-  return tasks;
-}
-
-
-Task* TP::getNearestTask(Agent* a, std::vector<Task*>& tasks) {
-  if (tasks.empty()) {
-    std::cout << "Error@TP::getNearestTask, cannot get task" << "\n";
-    exit(1);
-  }
-  Node* v = a->getNode();
-  Graph* _G = G;
-  auto itr = std::min_element(tasks.begin(), tasks.end(),
-                              [v, _G](Task* tau1, Task* tau2) {
-                                return _G->dist(v, tau1->getG()[0])
-                                  < _G->dist(v, tau2->getG()[0]); });
-  return *itr;
+  return nearest;
 }
 
 Nodes TP::getPath(Agent* a, int startTime) {
@@ -228,14 +267,7 @@ Nodes TP::getPath(Agent* a,
   AN_OLD *l, *n;
   int t, f, cost;
   std::string key;
-  bool prohibited, goalCheck;
-
-  Nodes pathends;
-  Node* v;
-  for (auto p : paths) {
-    v = p[p.size() - 1];
-    if (v != s && v != a->getNode()) pathends.push_back(v);
-  }
+  bool goalCheck;
 
   std::unordered_set<std::string> OPEN;
   std::unordered_map<std::string, AN_OLD*> table;
@@ -267,17 +299,8 @@ Nodes TP::getPath(Agent* a,
       goalCheck = true;
 
       if (futureCollision) {
-        for (auto p : paths) {
-          if (t + 1 >= p.size()) continue;
-
-          for (auto itr = p.begin() + t + 1; itr < p.end(); ++itr) {
-            if ((*itr) == n->v) {  // collision in future
-              goalCheck = false;
-              break;
-            }
-          }
-          if (!goalCheck) break;
-        }
+        // collision in future
+        if (reservation->getLastTime(n->v) > t) goalCheck = false;
       }
 
       if (goalCheck) {
@@ -293,28 +316,17 @@ Nodes TP::getPath(Agent* a,
     // search neighbor
     C = { n->v };
     for (auto u : G->neighbor(n->v)) {
-      if (!inArray(u, pathends)) C.push_back(u);
+      if (u == s || u == a->getNode() || pathEndCnt[u->getIndex()] == 0) {
+        C.push_back(u);
+      }
     }
 
     for (auto m : C) {
       t = n->t + 1;
 
       if (t > 0) {
-        prohibited = false;
-
-        for (auto p : paths) {
-          if (t + 1 > p.size()) continue;
-          if (p[t] == m) { // collision
-            prohibited = true;
-            break;
-          }
-          if (p[t] == n->v && p[t-1] == m) {  // intersection
-            prohibited = true;
-            break;
-          }
-        }
-
-        if (prohibited) continue;
+        if (reservation->isOccupied(t, m)) continue;  // collision
+        if (reservation->isSwapped(t, n->v, m)) continue;  // intersection
       }
 
       key = getKey(t, m);
@@ -372,7 +384,7 @@ Nodes TP::getPickDelivPath(Agent* a,
   AN2 *l, *n;
   int t, f, cost;
   std::string key;
-  bool prohibited, goalCheck;
+  bool goalCheck;
 
   Nodes pathends;
   Node* v;
@@ -413,17 +425,8 @@ Nodes TP::getPickDelivPath(Agent* a,
       goalCheck = true;
 
       if (futureCollision) {
-        for (auto p : paths) {
-          if (t + 1 >= p.size()) continue;
-
-          for (auto itr = p.begin() + t + 1; itr < p.end(); ++itr) {
-            if ((*itr) == n->v) {  // collision in future
-              goalCheck = false;
-              break;
-            }
-          }
-          if (!goalCheck) break;
-        }
+        // collision in future
+        if (reservation->getLastTime(n->v) > t) goalCheck = false;
       }
 
       if (goalCheck) break;
@@ -439,28 +442,17 @@ Nodes TP::getPickDelivPath(Agent* a,
     // search neighbor
     C = { n->v };
     for (auto u : G->neighbor(n->v)) {
-      if (!inArray(u, pathends)) C.push_back(u);
+      if (u == s || u == a->getNode() || pathEndCnt[u->getIndex()] == 0) {
+        C.push_back(u);
+      }
     }
 
     for (auto m : C) {
       t = n->t + 1;
 
       if (t > 0) {
-        prohibited = false;
-
-        for (auto p : paths) {
-          if (t + 1 > p.size()) continue;
-          if (p[t] == m) { // collision
-            prohibited = true;
-            break;
-          }
-          if (p[t] == n->v && p[t-1] == m) {  // intersection
-            prohibited = true;
-            break;
-          }
-        }
-
-        if (prohibited) continue;
+        if (reservation->isOccupied(t, m)) continue;  // collision
+        if (reservation->isSwapped(t, n->v, m)) continue;  // intersection
       }
 
       key = getKey(t, m);
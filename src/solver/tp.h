@@ -1,6 +1,7 @@
 #pragma once
 
 #include "solver.h"
+#include "reservation.h"
 
 
 class TP : public Solver {
@@ -10,14 +11,28 @@ private:
   Paths paths;
   bool status;
 
+  ReservationTable* reservation;
+  std::vector<int> reservedLength;  // how many nodes of each path are in table
+
+  // indexes, node index -> ...
+  std::vector<int> pathEndCnt;   // number of paths ending there
+  std::vector<int> pathEnds;     // agent -> node index of the end of its path
+  std::vector<int> deliveryCnt;  // number of open tasks delivering there
+  std::vector<std::vector<Task*>> pickupTasks;  // open tasks, ordered by id
+  std::vector<int> pickupNodes;  // node indexes with non-empty pickupTasks
+  int indexedTaskNum;  // head of T_OPEN already in the indexes
+
   void init();
   void update();
+  void registerPath(int i);
+  void registerNewTasks();
+  void unregisterTask(Task* tau);
+  bool isBlocked(Node* u, Node* v);
 
   bool shouldAvoid(Agent* a, int timestep);
-  std::vector<Task*> getExecutableTask(Agent* a, int timestep);
+  Task* getNearestExecutableTask(Agent* a);
   void updatePath1(Agent* a, int startTime);
   void updatePath2(Agent* a, int startTime);
-  Task* getNearestTask(Agent* a, std::vector<Task*>& tasks);
 
   Nodes getPath(Agent* a, int startTime);
   Nodes getPath(Agent* a,
@@ -13,6 +13,51 @@
 #include <algorithm>
 
 
+RRA::RRA(Graph* _G, Node* _s, Node* _g,
+         std::vector<std::vector<int>>* _predecessors)
+  : G(_G), s(_s), predecessors(_predecessors), g(_g)
+{
+  int nodeNum = G->getNodesNum();
+  gVal = std::vector<int>(nodeNum, nodeNum);
+  closed = std::vector<bool>(nodeNum, false);
+  gVal[g->getIndex()] = 0;
+  OPEN.push(std::make_pair(G->dist(g, s), g->getIndex()));
+}
+
+// resume the backward search until v is closed
+int RRA::dist(Node* v) {
+  int index = v->getIndex();
+  if (closed[index]) return gVal[index];
+
+  int k, d;
+  while (!OPEN.empty()) {
+    k = OPEN.top().second;
+    OPEN.pop();
+    if (closed[k]) continue;
+    closed[k] = true;
+
+    d = gVal[k] + 1;
+    if (predecessors != nullptr) {
+      for (auto j : (*predecessors)[k]) {
+        if (closed[j] || gVal[j] <= d) continue;
+        gVal[j] = d;
+        OPEN.push(std::make_pair(d + G->dist(G->getNodeFromIndex(j), s), j));
+      }
+    } else {
+      for (auto u : G->neighbor(G->getNodeFromIndex(k))) {
+        int j = u->getIndex();
+        if (closed[j] || gVal[j] <= d) continue;
+        gVal[j] = d;
+        OPEN.push(std::make_pair(d + G->dist(u, s), j));
+      }
+    }
+
+    if (k == index) return gVal[index];
+  }
+
+  return gVal[index];  // unreachable
+}
+
 // HCA*
 WHCA::WHCA(Problem* _P) : Solver(_P) {
   hasWindow = false;
@@ -26,12 +71,69 @@ WHCA::WHCA(Problem* _P, int _w) : Solver(_P), window(_w) {
 }
 
 WHCA::~WHCA() {
-  for (auto cg : CGOAL) delete cg;
-  CGOAL.clear();
+  delete reservation;
+  for (auto itr : RRAs) delete itr.second;
 }
 
 void WHCA::init() {
   G->setRegFlg(true);
+  if (hasWindow) {
+    reservation = new ReservationTable(G->getNodesNum(), window);
+  } else {
+    reservation = new ReservationTable(G->getNodesNum());
+  }
+  reservedLength = std::vector<int>(A.size(), 0);
+  if (G->isDirected()) buildPredecessors();
+  goalOccupied.resize(G->getNodesNum());
+}
+
+void WHCA::registerGoal(Agent* a, int t) {
+  for (auto& entry : goalOccupied[a->getGoal()->getIndex()]) {
+    if (entry.first != a) continue;
+    entry.second = std::min(entry.second, t);
+    return;
+  }
+  goalOccupied[a->getGoal()->getIndex()].push_back(std::make_pair(a, t));
+}
+
+// whether another agent stays at v eventually
+bool WHCA::isGoalOccupied(Node* v, Agent* a) {
+  for (auto& entry : goalOccupied[v->getIndex()]) {
+    if (entry.first != a) return true;
+  }
+  return false;
+}
+
+// whether another agent stays at v at t
+bool WHCA::isGoalOccupied(Node* v, Agent* a, int t) {
+  for (auto& entry : goalOccupied[v->getIndex()]) {
+    if (entry.first != a && t >= entry.second) return true;
+  }
+  return false;
+}
+
+// distance from v to the goal of a, RRA* is reset when the goal changes
+int WHCA::trueDist(Agent* a, Node* v) {
+  RRA*& rra = RRAs[a->getId()];
+  if (rra != nullptr && rra->g != a->getGoal()) {
+    delete rra;
+    rra = nullptr;
+  }
+  if (rra == nullptr) {
+    rra = new RRA(G, a->getNode(), a->getGoal(),
+                  G->isDirected() ? &predecessors : nullptr);
+  }
+  return rra->dist(v);
+}
+
+// register new part of paths[i] to the reservation table
+void WHCA::reservePath(int i, Paths& paths) {
+  int id = A[i]->getId();
+  for (int t = reservedLength[i]; t < paths[i].size(); ++t) {
+    reservation->reserve(t, paths[i][t], id);
+    if (t > 0) reservation->reserve(t, paths[i][t-1], paths[i][t], id);
+  }
+  reservedLength[i] = paths[i].size();
 }
 
 bool WHCA::solve() {
@@ -44,8 +146,11 @@ bool WHCA::solve() {
 
   // initialize path
   for (auto a : A) PATHS.push_back({ a->getNode() });
+  for (int i = 0; i < A.size(); ++i) reservePath(i, PATHS);
 
   while (!P->isSolved()) {
+    reservation->releaseBefore(t);
+
     for (int i = 0; i < A.size(); ++i) {
       Nodes path = getPath(A[i], t, PATHS);
 
@@ -57,16 +162,17 @@ bool WHCA::solve() {
 
       // reach goal
       if (!hasWindow) {
-        CG* cg = new CG { A[i], (int)path.size() - 1, A[i]->getGoal() };
-        CGOAL.push_back(cg);
+        registerGoal(A[i], (int)path.size() - 1);
       }
 
       PATHS[i].insert(PATHS[i].end(), path.begin() + 1, path.end());
+      reservePath(i, PATHS);
     }
 
     if (failed) break;
 
     formalizePath(PATHS);
+    for (int i = 0; i < A.size(); ++i) reservePath(i, PATHS);
     limit = std::min(window, (int)PATHS[0].size() - t);
     for (int _t = 0; _t < limit; ++_t) {
       ++t;
@@ -88,14 +194,13 @@ Nodes WHCA::getPath(Agent* a, int startTime, Paths& paths) {
   Node* _s = a->getNode();
   Node* _g = a->getGoal();
 
-  Nodes path, tmpPath, C;
+  Nodes path, tmpPath;
 
-  int f, g;
-  std::string key;
   bool prohibited = false;
   int maxLength = getMaxLengthPaths(paths);
 
   // ==== fast implementation ====
+  // same successors as before, RRA* is used only for f-values
   tmpPath = G->getPath(_s, _g);
   if (hasWindow) {
     while (tmpPath.size() <= window + 1) tmpPath.push_back(_g);
@@ -106,37 +211,23 @@ Nodes WHCA::getPath(Agent* a, int startTime, Paths& paths) {
   // check result of fast implementation
   // first, check goals
   if (!hasWindow) {
-    for (auto cg : CGOAL) {
-      if (cg->a == a) continue;
-      for (auto v : tmpPath) {
-        if (cg->v == v) {
-          prohibited = true;
-          break;
-        }
+    for (auto v : tmpPath) {
+      if (isGoalOccupied(v, a)) {
+        prohibited = true;
+        break;
       }
-      if (prohibited) break;
     }
   }
   // second, check collision and intersection
   if (!prohibited) {
-    int limit;
-    for (auto p : paths) {
-      limit = p.size();
-      if (hasWindow) limit = startTime + window + 1;
-      for (int t = startTime + 1; t < limit; ++t) {
-        if (t >= p.size()) break;
-        if (p[t] == tmpPath[t-startTime]) { // collision
-          prohibited = true;
-          break;
-        }
-        if (t > startTime) {  // intersection
-          if (p[t] == tmpPath[t-startTime-1] && p[t-1] == tmpPath[t-startTime]) {
-            prohibited = true;
-            break;
-          }
-        }
+    int id = a->getId();
+    for (int t = startTime + 1; t < startTime + tmpPath.size(); ++t) {
+      if (reservation->isOccupied(t, tmpPath[t-startTime], id)  // collision
+          || reservation->isSwapped(t, tmpPath[t-startTime-1],  // intersection
+                              tmpPath[t-startTime], id)) {
+        prohibited = true;
+        break;
       }
-      if (prohibited) break;
     }
   }
   // success of fast implementation
@@ -145,101 +236,26 @@ Nodes WHCA::getPath(Agent* a, int startTime, Paths& paths) {
   // =============================
 
   // normal path finding
-  bool invalid = true;
-
-  boost::heap::fibonacci_heap<Fib_AN> OPEN;
-  std::unordered_map<std::string, boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
-  std::unordered_set<std::string> CLOSE;  // key
-  AN* n = new AN { _s, startTime, pathDist(_s, _g), nullptr };
-  auto handle = OPEN.push(Fib_AN(n));
-  key = getKey(n);
-  SEARCHED.emplace(key, handle);
-
-  while (!OPEN.empty()) {
-    // argmin
-    n = OPEN.top().node;
-
+  AN* n = astar.search(
+    G, _s, startTime, trueDist(a, _s),
     // check termination condition
-    if (!hasWindow) {  // non-window
-      if (n->v == _g && n->g >= maxLength - 1) {
-        invalid = false;
-        break;
-      }
-    } else {  // windowed
-      if (n->g >= startTime + window) {
-        invalid = false;
-        break;
-      }
-    }
-
-    // update list
-    OPEN.pop();
-    CLOSE.emplace(getKey(n));
-
-    // search neighbor
-    C = G->neighbor(n->v);
-    C.push_back(n->v);
-
-    for (auto m : C) {
-      // check other paths
-      g = n->g + 1;
-      key = getKey(g, m);
-      if (CLOSE.find(key) != CLOSE.end()) continue;
-
+    [&] (AN* n) {
+      if (!hasWindow) return n->v == _g && n->g >= maxLength - 1;  // non-window
+      return n->g >= startTime + window;  // windowed
+    },
+    [] (AN*& n) { return false; },
+    [&] (AN* n, Node* m, int g) {
       // check collision
-      prohibited = false;
-      for (auto p : paths) {
-        if (g >= p.size()) continue;
-        if (p[g] == m) {  // vertex collision
-          prohibited = true;
-          break;
-        }
-        if (p[g] == n->v && p[g-1] == m) {  // swap collision
-          prohibited = true;
-          break;
-        }
-      }
-      if (prohibited) continue;
-
+      if (reservation->isOccupied(g, m, a->getId())) return false;  // vertex collision
+      if (reservation->isSwapped(g, n->v, m, a->getId())) return false;  // swap collision
       // collsiion at goal
-      if (!hasWindow) {
-        for (auto cg : CGOAL) {  // collection of goals
-          if (a != cg->a && g >= cg->t && m == cg->v) {
-            prohibited = true;
-            break;
-          }
-        }
-        if (prohibited) continue;
-      }
-
-      f = g + pathDist(m, _g);
-
-      auto itrS = SEARCHED.find(key);
-      if (itrS == SEARCHED.end()) {  // new node
-        AN* l = new AN { m, g, f, n };
-        auto handle = OPEN.push(Fib_AN(l));
-        SEARCHED.emplace(key, handle);
-      } else {
-        auto handle = itrS->second;
-        AN* l = (*handle).node;
-        if (l->f > f) {
-          l->g = g;
-          l->f = f;
-          l->p = n;
-        }
-        OPEN.increase(handle);
-      }
-    }
-  }
+      if (!hasWindow && isGoalOccupied(m, a, g)) return false;
+      return true;
+    },
+    [&] (AN* n, Node* m, int g) { return g + trueDist(a, m); });
 
   // back tracking
-  if (!invalid) {  // check failed or not
-    while (n != nullptr) {
-      path.push_back(n->v);
-      n = n->p;
-    }
-    std::reverse(path.begin(), path.end());
-  }
+  if (n != nullptr) path = astar.getPath(n);  // check failed or not
 
   return path;
 }
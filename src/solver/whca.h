@@ -1,11 +1,30 @@
 #pragma once
 
 #include "solver.h"
+#include "reservation.h"
+#include "astar.h"
+#include <queue>
 
-struct CG {  // constraint of goal, for agents who have reached goals
-  Agent* a;
-  int t;
-  Node* v;
+// Reverse Resumable A*, exact distance to the goal expanded on demand
+class RRA {
+private:
+  Graph* G;
+  Node* s;  // target of the reverse search, usually initial location
+  std::vector<std::vector<int>>* predecessors;  // nullptr -> undirected
+  std::vector<int> gVal;  // distance to the goal, tentative if not closed
+  std::vector<bool> closed;
+  std::priority_queue<std::pair<int, int>,  // (f, node index)
+                      std::vector<std::pair<int, int>>,
+                      std::greater<std::pair<int, int>>> OPEN;
+
+public:
+  Node* const g;
+
+  RRA(Graph* _G, Node* _s, Node* _g,
+      std::vector<std::vector<int>>* _predecessors);
+  ~RRA() {};
+
+  int dist(Node* v);  // unreachable -> number of nodes
 };
 
 class WHCA : public Solver {
@@ -13,9 +32,22 @@ private:
   bool hasWindow;  // HCA* or WHCA*
   int window;
 
-  std::vector<CG*> CGOAL;  // goals that agents have already reached
+  // goals that agents have already reached
+  // node index -> (agent, time from which the agent stays there)
+  std::vector<std::vector<std::pair<Agent*, int>>> goalOccupied;
+  void registerGoal(Agent* a, int t);
+  bool isGoalOccupied(Node* v, Agent* a);
+  bool isGoalOccupied(Node* v, Agent* a, int t);
+
+  ReservationTable* reservation;
+  std::vector<int> reservedLength;  // how many nodes of each path are in table
+
+  std::unordered_map<int, RRA*> RRAs;  // agent id -> heuristic
+  SpaceTimeAstar astar;
 
   void init();
+  void reservePath(int i, Paths& paths);
+  int trueDist(Agent* a, Node* v);
   Nodes getPath(Agent* a, int startTime, Paths& paths);
 
 public:
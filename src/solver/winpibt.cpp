@@ -23,22 +23,75 @@ winPIBT::winPIBT(Problem* _P, int _w, bool _softmode, std::mt19937* _MT)
   init();
 }
 
-winPIBT::~winPIBT() {}
+winPIBT::~winPIBT() {
+  delete reservation;
+}
 
 void winPIBT::init() {
   G->setRegFlg(true);
 
   // initialize priroirty and paths
+  reservation = new ReservationTable(G->getNodesNum(), w);
+  lastNodeAgents.resize(G->getNodesNum());
   int agentNum = A.size();
   for (int i = 0; i < agentNum; ++i) {
     epsilon.push_back((float)i / agentNum);
     eta.push_back(0);
     priority.push_back(epsilon[i] + eta[i]);
-    PATHS.push_back({A[i]->getNode()});
+    PATHS.push_back(RollingPath());
+    pushPath(i, A[i]->getNode());
     L.push_back(0);
+    lastNodeIndex.push_back(A[i]->getNode()->getIndex());
+    lastNodeAgents[lastNodeIndex[i]].push_back(i);
   }
 }
 
+// update ell with the index of last planned nodes
+void winPIBT::setEll(int id, int t) {
+  std::vector<int>& from = lastNodeAgents[lastNodeIndex[id]];
+  from.erase(std::find(from.begin(), from.end(), id));
+  L[id] = t;
+  lastNodeIndex[id] = lastNode(id)->getIndex();
+  lastNodeAgents[lastNodeIndex[id]].push_back(id);
+}
+
+void winPIBT::pushPath(int id, Node* v) {
+  int t = PATHS[id].size();
+  reservation->reserve(t, v, id);
+  if (t > 0) reservation->reserve(t, PATHS[id][t-1], v, id);
+  PATHS[id].push_back(v);
+
+  if (t > 0) countPathSize(t, -1);
+  countPathSize(t + 1, 1);
+}
+
+void winPIBT::popPath(int id) {
+  int t = PATHS[id].size() - 1;
+  reservation->release(t, PATHS[id][t], id);
+  if (t > 0) reservation->release(t, PATHS[id][t-1], PATHS[id][t], id);
+  PATHS[id].pop_back();
+
+  countPathSize(t + 1, -1);
+  countPathSize(t, 1);
+}
+
+void winPIBT::countPathSize(int size, int diff) {
+  int& cnt = pathSizeCnt[size];
+  cnt += diff;
+  if (cnt == 0) pathSizeCnt.erase(size);
+}
+
+void winPIBT::setPath(int id, int t, Node* v) {
+  RollingPath& path = PATHS[id];
+  reservation->release(t, path[t], id);
+  if (t > 0) reservation->release(t, path[t-1], path[t], id);
+  if (t + 1 < path.size()) reservation->release(t + 1, path[t], path[t+1], id);
+  path[t] = v;
+  reservation->reserve(t, v, id);
+  if (t > 0) reservation->reserve(t, path[t-1], v, id);
+  if (t + 1 < path.size()) reservation->reserve(t + 1, v, path[t+1], id);
+}
+
 bool winPIBT::solve() {
   solveStart();
 
@@ -47,6 +100,8 @@ bool winPIBT::solve() {
   int i, _w;
 
   while (!P->isSolved()) {
+    reservation->releaseBefore(t);
+    for (auto& path : PATHS) path.trim(t);
     allocate();
     updatePriority();
     std::vector<int> U(A.size());
@@ -92,27 +147,6 @@ bool winPIBT::solve() {
   return true;
 }
 
-void winPIBT::allocate() {
-  if (P->allocated()) return;
-  auto T = P->getT();
-  Graph* _G = G;
-
-  for (auto a : A) {
-    if (a->hasTask()) continue;
-    if (T.empty()) {
-      a->releaseGoalOnly();
-    } else {
-      auto v = a->getNode();
-      auto itr = std::min_element(T.begin(), T.end(),
-                                  [v, _G] (Task* t1, Task* t2) {
-                                    return _G->dist(t1->getG()[0], v)
-                                      < _G->dist(t2->getG()[0], v);
-                                  });
-      a->setGoal((*itr)->getG()[0]);
-    }
-  }
-}
-
 int winPIBT::ell(Agent* a) {
   return ell(a->getId());
 }
@@ -145,8 +179,8 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
   Node* g = getGoal(a);
 
   if (varphi && lastNode(i) == g) {
-    PATHS[i].push_back(g);
-    L[i] += 1;
+    pushPath(i, g);
+    setEll(i, L[i] + 1);
     return true;
   }
 
@@ -157,9 +191,9 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
   if (path.empty()) {
     v = PATHS[i][l];
     for (int _t = l + 1; _t <= t_tmp; ++_t) {
-      PATHS[i].push_back(v);
+      pushPath(i, v);
     }
-    L[i] = t_tmp;
+    setEll(i, t_tmp);
     return false;
   }
 
@@ -168,7 +202,7 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
   // future information
   int t_dtmp = t_tmp;
   for (int j = _t; j <= t_tmp; ++j) {
-    PATHS[i].push_back(path[j - l]);
+    pushPath(i, path[j - l]);
     if (varphi && path[j - l] == g) {
       t_dtmp = j;
       break;
@@ -177,7 +211,7 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
 
   while (_t <= t_dtmp) {
     v = PATHS[i][_t];
-    L[i] = _t;
+    setEll(i, _t);
 
     auto itrA = findPITargetAgent(v, _t - 1);
     while (itrA != A.end()) {
@@ -189,18 +223,18 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
     if (itrA != A.end()) {
       if (!winpibt(*itrA, _t, false)) {
         for (int j = _t; j <= t_dtmp; ++j) {
-          PATHS[i].erase(PATHS[i].end() - 1);
+          popPath(i);
         }
-        L[i] = _t - 1;
+        setEll(i, _t - 1);
         Nodes newPath = getPath(a, g, _t - 1, t_max);
 
         if (newPath.empty()) {
 
           v = PATHS[i][_t - 1];
           for (int __t = _t; __t <= t_dtmp; ++__t) {
-            PATHS[i].push_back(v);
+            pushPath(i, v);
           }
-          L[i] = t_dtmp;
+          setEll(i, t_dtmp);
 
           return false;
 
@@ -208,7 +242,7 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
 
           t_dtmp = t_tmp;
           for (int j = _t; j <= t_dtmp; ++j) {
-            PATHS[i].push_back(newPath[j - _t + 1]);
+            pushPath(i, newPath[j - _t + 1]);
             if (varphi && newPath[j - _t + 1] == g) {
               t_dtmp = j;
               break;
@@ -228,7 +262,7 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
       if (_t < t_dtmp) {
         Nodes newPath = getPath(a, g, _t, t_max);
         for (int j = _t + 1; j <= t_dtmp; ++j) {
-          PATHS[i][j] = newPath[j - _t];
+          setPath(i, j, newPath[j - _t]);
         }
       }
     }
@@ -239,16 +273,15 @@ bool winPIBT::winpibt(Agent* a, int t_tmp, bool varphi)
   return true;
 }
 
+// first agent in A whose last planned node is v before t
 Agents::iterator winPIBT::findPITargetAgent(Node* v, int t) {
-  auto itr = std::find_if(A.begin(), A.end(),
-                          [this, v, t] (Agent* b) {
-                            int id = b->getId();
-                            int j = this->ell(id);
-                            if (j >= t) return false;
-                            if (this->lastNode(id) != v) return false;
-                            return true;
-                          });
-  return itr;
+  int target = -1;
+  for (auto id : lastNodeAgents[v->getIndex()]) {
+    if (ell(id) >= t) continue;
+    if (target == -1 || id < target) target = id;
+  }
+  if (target == -1) return A.end();
+  return A.begin() + target;
 }
 
 Node* winPIBT::lastNode(Agent* a) {
@@ -276,127 +309,60 @@ Nodes winPIBT::getPath(Agent* a, Node* _g, int t1, int t2) {
 
   int id = a->getId();
   Node* _s = PATHS[a->getId()][t1];  // start pos
-  Nodes path, tmpPath, C;
-  int f, g;
-  std::string key;
-  bool invalid = true;  // success or not
-
-  boost::heap::fibonacci_heap<Fib_AN> OPEN;
-  std::unordered_map<std::string,
-                     boost::heap::fibonacci_heap<Fib_AN>::handle_type> SEARCHED;
-  std::unordered_set<std::string> CLOSE;  // key
-  AN* n = new AN { _s, t1, pathDist(_s, _g), nullptr };
-  auto handle = OPEN.push(Fib_AN(n));
-  key = getKey(n);
-  SEARCHED.emplace(key, handle);
-
-  while (!OPEN.empty()) {
-    // argmin
-    n = OPEN.top().node;
+  Nodes path, tmpPath;
 
+  AN* n = astar.search(
+    G, _s, t1, pathDist(_s, _g),
     // check goal
-    if (n->g >= t2) {
-      invalid = false;
-      break;
-    }
-
+    [&] (AN* n) { return n->g >= t2; },
     // ==== fast implementation ====
-    tmpPath = G->getPath(n->v, _g);
-    while (n->g + tmpPath.size() - 1 < t2) tmpPath.push_back(_g);
-    while (n->g + tmpPath.size() - 1 > t2) tmpPath.pop_back();
-    if (checkValidPath(id, tmpPath, n->g, t2)) {
-      tmpPath.erase(tmpPath.begin());
-      for (auto v : tmpPath) n = new AN { v, n->g + 1, 0, n };
-      invalid = false;
-      break;
-    }
+    [&] (AN*& n) {
+      tmpPath = G->getPath(n->v, _g);
+      while (n->g + tmpPath.size() - 1 < t2) tmpPath.push_back(_g);
+      while (n->g + tmpPath.size() - 1 > t2) tmpPath.pop_back();
+      if (!checkValidPath(id, tmpPath, n->g, t2)) return false;
+      for (int i = 1; i < tmpPath.size(); ++i) n = astar.append(n, tmpPath[i]);
+      return true;
+    },
     // =============================
-
-    // update list
-    OPEN.pop();
-    CLOSE.emplace(getKey(n));
-
-    // search neighbor
-    C = G->neighbor(n->v);
-    C.push_back(n->v);
-
-    for (auto m : C) {
-      g = n->g + 1;
-      key = getKey(g, m);
-      if (CLOSE.find(key) != CLOSE.end()) continue;
-
-      // collision check
+    // collision check
+    [&] (AN* n, Node* m, int g) {
       tmpPath = { n->v, m };
-      if (!checkValidPath(id, tmpPath, n->g, t2)) continue;
-
-      f = g + pathDist(m, _g);
-      auto itrS = SEARCHED.find(key);
-      if (itrS == SEARCHED.end()) {  // new node
-        AN* l = new AN { m, g, f, n };
-        auto handle = OPEN.push(Fib_AN(l));
-        SEARCHED.emplace(key, handle);
-      } else {
-        auto handle = itrS->second;
-        AN* l = (*handle).node;
-        if (l->f > f) {
-          l->g = g;
-          l->f = f;
-          l->p = n;
-        }
-        OPEN.increase(handle);
-      }
-    }
-  }
+      return checkValidPath(id, tmpPath, n->g, t2);
+    },
+    [&] (AN* n, Node* m, int g) { return g + pathDist(m, _g); });
 
   // back tracking
-  if (!invalid) {  // check failed or not
-    while (n != nullptr) {
-      path.push_back(n->v);
-      n = n->p;
-    }
-    std::reverse(path.begin(), path.end());
-  }
+  if (n != nullptr) path = astar.getPath(n);  // check failed or not
 
   return path;
 }
 
 bool winPIBT::checkValidPath(int id, Nodes &path, int t1, int t2) {
-  int k;
   Node *v1, *v2;
+  int t;
 
   for (int j = 1; j < path.size(); ++j) {
     v1 = path[j-1];
     v2 = path[j];
-    for (int i = 0; i < A.size(); ++i) {
-      if (id == i) continue;
-
-      k = ell(i);
-      for (int _t = j + t1 + 1; _t <= t2; ++_t) {
-        if (k < _t) break;
-        if (PATHS[i][_t] == v2) {  // vertex collision
-          return false;
-        }
-      }
+    t = j + t1;
 
-      if (PATHS[i].size() - 1 < j + t1) continue;
-      if (PATHS[i][j + t1] == v2) {  // collision
-        return false;
-      }
-      if (v1 == PATHS[i][j + t1] && v2 == PATHS[i][j + t1 - 1]) {
-        return false;
+    // vertex collision, with fixed part of others' future
+    for (int _t = t + 1; _t <= t2; ++_t) {
+      for (auto i : reservation->getAgents(_t, v2)) {
+        if (i != id && ell(i) >= _t) return false;
       }
-
     }
+
+    if (reservation->isOccupied(t, v2, id)) return false;  // collision
+    if (reservation->isSwapped(t, v1, v2, id)) return false;  // swap
   }
 
   return true;
 }
 
 int winPIBT::getTmax(int t_tmp) {
-  auto itrP = std::max_element(PATHS.begin(), PATHS.end(),
-                               [] (Nodes a, Nodes b)
-                               { return a.size() < b.size(); });
-  int size = itrP->size() - 1;
+  int size = pathSizeCnt.rbegin()->first - 1;
   if (t_tmp > size) return t_tmp;
   return size;
 }
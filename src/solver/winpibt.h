@@ -7,17 +7,75 @@
 
 #pragma once
 #include "solver.h"
+#include "reservation.h"
+#include "astar.h"
+#include <map>
 
 
+// plan of one agent holding only the recent part, indexed by absolute time
+// valid range is [offset, size()), older steps live in agents' histories
+class RollingPath {
+private:
+  std::vector<Node*> buf;  // ring, capacity is a power of two
+  int head;    // position of time offset in buf
+  int offset;  // time of the oldest node held
+  int len;
+
+  void grow() {
+    std::vector<Node*> newBuf(buf.size() * 2);
+    for (int k = 0; k < len; ++k) newBuf[k] = buf[(head + k) & (buf.size() - 1)];
+    buf.swap(newBuf);
+    head = 0;
+  }
+
+public:
+  RollingPath() : buf(16), head(0), offset(0), len(0) {}
+
+  int size() const { return offset + len; }
+  Node*& operator[](int t) {
+    return buf[(head + t - offset) & (buf.size() - 1)];
+  }
+  void push_back(Node* v) {
+    if (len == buf.size()) grow();
+    buf[(head + len) & (buf.size() - 1)] = v;
+    ++len;
+  }
+  void pop_back() { --len; }
+  // drop nodes before t, the last node is always kept
+  void trim(int t) {
+    while (offset < t && len > 1) {
+      head = (head + 1) & (buf.size() - 1);
+      ++offset;
+      --len;
+    }
+  }
+};
+
 class winPIBT : public Solver {
 protected:
   int w;  // window size
   bool softmode;
-  Paths PATHS;
-  std::vector<int> L;
+  std::vector<RollingPath> PATHS;
+  std::vector<int> L;  // modify only via setEll
   std::vector<float> epsilon;
   std::vector<int> eta;
   std::vector<float> priority;
+  ReservationTable* reservation;  // mirror of PATHS
+  SpaceTimeAstar astar;
+
+  // all modifications of PATHS go through these
+  void pushPath(int id, Node* v);
+  void popPath(int id);
+  void setPath(int id, int t, Node* v);
+
+  // node index -> agents whose last planned node is there
+  std::vector<std::vector<int>> lastNodeAgents;
+  std::vector<int> lastNodeIndex;  // agent -> its key in lastNodeAgents
+  void setEll(int id, int t);
+
+  // path size -> number of agents, for getTmax
+  std::map<int, int> pathSizeCnt;
+  void countPathSize(int size, int diff);
 
   int ell(Agent* a);
   int ell(int i);
@@ -29,7 +87,6 @@ protected:
   int getTmax(int t_tmp);
 
   void init();
-  void allocate();
 
   virtual bool winpibt(Agent* a, int t_tmp, bool varphi);
 
@@ -52,6 +52,11 @@ void Task::update(Node* g) {
   openToClose(g, G_OPEN, G_CLOSE);
 }
 
+void Task::reset() {
+  G_OPEN.insert(G_OPEN.begin(), G_CLOSE.begin(), G_CLOSE.end());
+  G_CLOSE.clear();
+}
+
 bool Task::completed() {
   return G_OPEN.empty();
 }
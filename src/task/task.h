@@ -33,6 +33,7 @@ public:
   Node* getNext(Node* v);
 
   void update(Node* v);
+  void reset();  // visited nodes are visited again
 
   bool completed();
   void setEndTime(int t);
@@ -22,7 +22,8 @@ namespace Param {
                      S_PPS,
                      S_TP,
                      S_PIBT,
-                     S_winPIBT };
+                     S_winPIBT,
+                     S_pPIBT };
 
   // params of problem setting
   struct EnvConfig {
@@ -57,6 +58,22 @@ namespace Param {
 
     // for winPIBT
     bool softmode;
+
+    // for PIBT, time budget of one step [ms], 0 -> no deadline
+    float deadline;
+
+    // for PIBT, prioritize by local density instead of elapsed time
+    bool density;
+
+    // for CBS, ECBS, number of threads of low-level search
+    // for pPIBT, number of workers planning inheritance trees
+    int threads;
+
+    // for CBS, split cardinal conflicts first
+    bool cardinal;
+
+    // for CBS, ECBS, adopt a child without branching if possible
+    bool bypass;
   };
 
   struct VisualConfig {
@@ -99,6 +116,11 @@ void setParams(std::string filename,
   std::regex r_window = std::regex(R"(window=(\d+))");
   std::regex r_suboptimal = std::regex(R"(suboptimal=(\d+[\.]?\d*))");
   std::regex r_softmode = std::regex(R"(softmode=(\d+))");
+  std::regex r_deadline = std::regex(R"(deadline=(\d+[\.]?\d*))");
+  std::regex r_density = std::regex(R"(density=(\d+))");
+  std::regex r_threads = std::regex(R"(threads=(\d+))");
+  std::regex r_cardinal = std::regex(R"(cardinal=(\d+))");
+  std::regex r_bypass = std::regex(R"(bypass=(\d+))");
   std::regex r_showicon = std::regex(R"(showicon=(\d+))");
   std::regex r_icon = std::regex(R"(icon=(.+))");
 
@@ -147,6 +169,8 @@ void setParams(std::string filename,
         env->STYPE = Param::SOLVER_TYPE::S_PIBT;
       } else if (tmpstr == "winPIBT") {
         env->STYPE = Param::SOLVER_TYPE::S_winPIBT;
+      } else if (tmpstr == "pPIBT") {
+        env->STYPE = Param::SOLVER_TYPE::S_pPIBT;
       } else {
         std::cout << "error@setParams, solver type "
                   << tmpstr
@@ -185,6 +209,16 @@ void setParams(std::string filename,
       solver->suboptimal = std::stof(results[1].str());
     } else if (std::regex_match(line, results, r_softmode)) {
       solver->softmode = std::stoi(results[1].str());
+    } else if (std::regex_match(line, results, r_deadline)) {
+      solver->deadline = std::stof(results[1].str());
+    } else if (std::regex_match(line, results, r_density)) {
+      solver->density = std::stoi(results[1].str());
+    } else if (std::regex_match(line, results, r_threads)) {
+      solver->threads = std::stoi(results[1].str());
+    } else if (std::regex_match(line, results, r_cardinal)) {
+      solver->cardinal = std::stoi(results[1].str());
+    } else if (std::regex_match(line, results, r_bypass)) {
+      solver->bypass = std::stoi(results[1].str());
     } else if (std::regex_match(line, results, r_showicon)) {
       visual->showicon = std::stoi(results[1].str());
     } else if (std::regex_match(line, results, r_icon)) {
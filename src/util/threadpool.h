@@ -0,0 +1,97 @@
+/*
+ * threadpool.h
+ *
+ * Purpose: fixed workers running a batch of indexed tasks
+ *
+ * The caller works as worker 0 and waits for the batch to end.
+ * Tasks are claimed one by one, so they should be coarse,
+ * e.g., one low-level search.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+  std::mutex mtx;
+  std::condition_variable cvTask;
+  std::condition_variable cvDone;
+  const std::function<void(int)>* task;
+  int taskNum;
+  int next;  // next task to be claimed
+  int done;  // number of finished tasks
+  bool stop;
+
+  static int& workerId() {
+    thread_local int id = 0;
+    return id;
+  }
+
+  // run tasks until all are claimed
+  void consume(std::unique_lock<std::mutex>& lock) {
+    while (next < taskNum) {
+      int i = next++;
+      const std::function<void(int)>* f = task;
+      lock.unlock();
+      (*f)(i);
+      lock.lock();
+      if (++done == taskNum) cvDone.notify_all();
+    }
+  }
+
+  void work(int id) {
+    workerId() = id;
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+      cvTask.wait(lock, [this] { return stop || next < taskNum; });
+      if (stop) return;
+      consume(lock);
+    }
+  }
+
+public:
+  // num: number of threads including the caller
+  ThreadPool(int num)
+    : task(nullptr), taskNum(0), next(0), done(0), stop(false)
+  {
+    for (int i = 1; i < num; ++i) {
+      workers.emplace_back(&ThreadPool::work, this, i);
+    }
+  }
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stop = true;
+    }
+    cvTask.notify_all();
+    for (auto& worker : workers) worker.join();
+  }
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int size() { return workers.size() + 1; }
+  static int getWorkerId() { return workerId(); }
+
+  // call f(0), ..., f(n-1) and wait for all of them
+  void run(int n, const std::function<void(int)>& f) {
+    if (workers.empty() || n <= 1) {
+      for (int i = 0; i < n; ++i) f(i);
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    task = &f;
+    taskNum = n;
+    next = 0;
+    done = 0;
+    cvTask.notify_all();
+    consume(lock);
+    cvDone.wait(lock, [this] { return done == taskNum; });
+  }
+};